@@ -0,0 +1,76 @@
+#include "value.hpp"
+#include "json.hpp"
+#include "arena.hpp"
+#include "taptests.hpp"
+#include <string>
+#include <vector>
+
+void
+test_arena (test::simple& ts)
+{
+    wjson::arena_type arena (256);
+    ts.ok (arena.capacity () == 0, "arena empty");
+    char* p = static_cast<char*> (arena.allocate (10));
+    char* q = static_cast<char*> (arena.allocate (10));
+    ts.ok (q - p == 16, "arena bump aligned 8");
+    arena.allocate (1000);
+    ts.ok (arena.capacity () == 256 + 1000, "arena large chunk");
+    arena.clear ();
+    ts.ok (arena.capacity () == 0, "arena clear");
+}
+
+void
+test_allocator (test::simple& ts)
+{
+    wjson::arena_type arena;
+    std::vector<int, wjson::arena_allocator<int>> heap {1, 2, 3};
+    ts.ok (arena.capacity () == 0, "allocator without scope uses heap");
+    {
+        wjson::arena_scope scope (arena);
+        std::vector<int, wjson::arena_allocator<int>> v {1, 2, 3};
+        v.push_back (4);
+        ts.ok (arena.capacity () > 0 && v.size () == 4 && v[3] == 4,
+            "allocator in scope uses arena");
+    }
+    ts.ok (wjson::current_arena () == nullptr, "scope restores current arena");
+}
+
+void
+test_document (test::simple& ts)
+{
+    wjson::document_type doc;
+    std::string input (R"q({"a":[1,2,3],"b":{"c":"d"}})q");
+    bool ok = wjson::decode_json (input, doc);
+    ts.ok (ok, "decode_json document");
+    ts.ok (doc.root ().get (L"a").get (2).fixnum () == 3
+        && doc.root ().get (L"b").get (L"c").string () == L"d", "document root");
+    ts.ok (wjson::current_arena () == nullptr, "decode restores current arena");
+}
+
+void
+test_copy (test::simple& ts)
+{
+    std::string input (R"q({"a key longer than a short string":{"b":[1,"c"]}})q");
+    wjson::value_type copy;
+    {
+        wjson::document_type doc;
+        wjson::decode_json (input, doc);
+        copy = doc.root ();
+    }
+    ts.ok (wjson::encode_json (copy) == input, "copy outlives document");
+    ts.ok (copy.get (L"a key longer than a short string").get (L"b").get (1).string ()
+        == L"c", "copy keys outlive document");
+}
+
+int
+main ()
+{
+    test::simple ts (12);
+
+    test_arena (ts);
+    test_allocator (ts);
+    test_document (ts);
+    test_copy (ts);
+
+    return ts.done_testing ();
+}
@@ -0,0 +1,48 @@
+#include <cstdlib>
+#include <new>
+#include "arena.hpp"
+
+namespace wjson {
+
+arena_type::arena_type (std::size_t const chunk_size)
+    : mchunk_size (chunk_size), mchunks (), mcapacity (0),
+      mtop (nullptr), mlimit (nullptr)
+{
+}
+
+arena_type::~arena_type ()
+{
+    clear ();
+}
+
+void
+arena_type::clear ()
+{
+    for (void* p : mchunks)
+        std::free (p);
+    mchunks.clear ();
+    mcapacity = 0;
+    mtop = nullptr;
+    mlimit = nullptr;
+}
+
+std::size_t
+arena_type::capacity () const
+{
+    return mcapacity;
+}
+
+void
+arena_type::grow (std::size_t const n)
+{
+    std::size_t const size = n > mchunk_size ? n : mchunk_size;
+    void* const p = std::malloc (size);
+    if (p == nullptr)
+        throw std::bad_alloc ();
+    mchunks.push_back (p);
+    mcapacity += size;
+    mtop = static_cast<char*> (p);
+    mlimit = mtop + size;
+}
+
+}//namespace wjson
@@ -0,0 +1,135 @@
+#pragma once
+
+/* monotonic arena for decoded documents.
+ *
+ * arena_type hands out memory from large chunks by bumping a pointer,
+ * and gives back all chunks at once when it is cleared or destroyed.
+ *
+ * arena_allocator is a stateless allocator that takes memory from
+ * the arena set to the current thread by arena_scope, or from the heap
+ * when no arena is set. each block starts with a word telling the arena
+ * it came from, so that deallocate frees heap blocks only and ignores
+ * arena blocks.
+ *
+ *      wjson::arena_type arena;
+ *      {
+ *          wjson::arena_scope scope (arena);
+ *          // containers allocated here live in the arena.
+ *      }
+ */
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace wjson {
+
+class arena_type {
+public:
+    explicit arena_type (std::size_t const chunk_size = 1024 * 1024);
+    ~arena_type ();
+    void* allocate (std::size_t const n);
+    void clear ();
+    std::size_t capacity () const;
+
+private:
+    std::size_t mchunk_size;
+    std::vector<void*> mchunks;
+    std::size_t mcapacity;
+    char* mtop;
+    char* mlimit;
+
+    void grow (std::size_t const n);
+
+    arena_type (arena_type const&);
+    arena_type& operator= (arena_type const&);
+};
+
+inline void*
+arena_type::allocate (std::size_t const n)
+{
+    std::size_t const size = (n + 7) & ~static_cast<std::size_t> (7);
+    if (static_cast<std::size_t> (mlimit - mtop) < size)
+        grow (size);
+    void* p = mtop;
+    mtop += size;
+    return p;
+}
+
+inline arena_type*&
+current_arena ()
+{
+    static thread_local arena_type* arena = nullptr;
+    return arena;
+}
+
+class arena_scope {
+public:
+    explicit arena_scope (arena_type& arena) : mprev (current_arena ())
+    {
+        current_arena () = &arena;
+    }
+    ~arena_scope () { current_arena () = mprev; }
+
+private:
+    arena_type* mprev;
+
+    arena_scope (arena_scope const&);
+    arena_scope& operator= (arena_scope const&);
+};
+
+template<typename T>
+class arena_allocator {
+public:
+    typedef T value_type;
+
+    arena_allocator () noexcept {}
+    template<typename U> arena_allocator (arena_allocator<U> const&) noexcept {}
+
+    T*
+    allocate (std::size_t const n)
+    {
+        static_assert (alignof (T) <= HEADER, "arena_allocator: over aligned");
+        std::size_t const size = HEADER + n * sizeof (T);
+        arena_type* const arena = current_arena ();
+        char* const p = static_cast<char*> (
+            arena ? arena->allocate (size) : ::operator new (size));
+        *reinterpret_cast<arena_type**> (p) = arena;
+        return reinterpret_cast<T*> (p + HEADER);
+    }
+
+    void
+    deallocate (T* const p, std::size_t const)
+    {
+        char* const q = reinterpret_cast<char*> (p) - HEADER;
+        if (*reinterpret_cast<arena_type**> (q) == nullptr)
+            ::operator delete (q);
+    }
+
+    // the arena of a block, or nullptr for a heap block.
+    static arena_type*
+    arena_of (T const* const p) noexcept
+    {
+        return *reinterpret_cast<arena_type* const*> (
+            reinterpret_cast<char const*> (p) - HEADER);
+    }
+
+private:
+    enum { HEADER = 8 };
+};
+
+template<typename T, typename U>
+inline bool
+operator== (arena_allocator<T> const&, arena_allocator<U> const&)
+{
+    return true;
+}
+
+template<typename T, typename U>
+inline bool
+operator!= (arena_allocator<T> const&, arena_allocator<U> const&)
+{
+    return false;
+}
+
+}//namespace wjson
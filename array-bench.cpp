@@ -0,0 +1,73 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include "value.hpp"
+
+// growth time of an array of small tables.
+//
+//      array-bench [count]
+
+static wjson::value_type
+make_item (std::size_t const i)
+{
+    wjson::value_type item = wjson::table ();
+    item.set (L"id", wjson::fixnum (i));
+    item.set (L"name", wjson::string (L"item " + std::to_wstring (i)));
+    item.set (L"score", wjson::flonum (i + 0.25));
+    wjson::value_type tags = wjson::array ();
+    tags.push_back (wjson::string (L"alpha"));
+    tags.push_back (wjson::string (L"beta"));
+    item.set (L"tags", std::move (tags));
+    return item;
+}
+
+static double
+msec (std::chrono::steady_clock::time_point const t0,
+    std::chrono::steady_clock::time_point const t1)
+{
+    return std::chrono::duration<double, std::milli> (t1 - t0).count ();
+}
+
+// moves prepared items into a growing array, so that the time is
+// the cost of reallocations.
+template<typename F>
+static void
+run (char const* name, std::size_t const count, F append)
+{
+    std::vector<wjson::value_type> items;
+    for (std::size_t i = 0; i < count; ++i)
+        items.push_back (make_item (i));
+    wjson::value_type root = wjson::array ();
+    auto t0 = std::chrono::steady_clock::now ();
+    append (root, items);
+    auto t1 = std::chrono::steady_clock::now ();
+    std::cout << name << msec (t0, t1) << " ms" << std::endl;
+}
+
+int
+main (int argc, char* argv[])
+{
+    typedef std::vector<wjson::value_type> items_type;
+    std::size_t const count = argc > 1 ? std::atol (argv[1]) : 1000000;
+    std::cout << "items: " << count << std::endl;
+
+    run ("push_back (value&&)     ", count,
+        [](wjson::value_type& root, items_type& items) {
+            for (auto& x : items)
+                root.push_back (std::move (x));
+        });
+    run ("emplace_back (value&&)  ", count,
+        [](wjson::value_type& root, items_type& items) {
+            for (auto& x : items)
+                root.emplace_back (std::move (x));
+        });
+    run ("reserve, emplace_back   ", count,
+        [](wjson::value_type& root, items_type& items) {
+            root.reserve (items.size ());
+            for (auto& x : items)
+                root.emplace_back (std::move (x));
+        });
+    return EXIT_SUCCESS;
+}
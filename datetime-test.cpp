@@ -0,0 +1,81 @@
+#include "datetime.hpp"
+#include "taptests.hpp"
+#include <string>
+
+void
+test_decode (test::simple& ts)
+{
+    wjson::datetime_type t;
+    ts.ok (wjson::decode_datetime ("1979-05-27T07:32:00Z", t)
+        && t.mseconds == 296638320 && t.mnanosecond == 0 && t.moffset == 0
+        && t.mform == wjson::DATETIME_OFFSET, "decode offset Z");
+    ts.ok (wjson::decode_datetime ("1979-05-27T00:32:00.999999-07:00", t)
+        && t.mseconds == 296638320 && t.mnanosecond == 999999000
+        && t.moffset == -420, "decode offset -07:00");
+    ts.ok (wjson::decode_datetime ("1979-05-27T07:32:00", t)
+        && t.mseconds == 296638320 && t.mform == wjson::DATETIME_LOCAL,
+        "decode local datetime");
+    ts.ok (wjson::decode_datetime ("1979-05-27", t)
+        && t.mseconds == 296611200 && t.mform == wjson::DATE_LOCAL,
+        "decode local date");
+    ts.ok (wjson::decode_datetime ("1969-12-31T23:59:59.5Z", t)
+        && t.mseconds == -1 && t.mnanosecond == 500000000, "decode before epoch");
+    ts.ok (wjson::decode_datetime ("2000-02-29", t), "decode leap day");
+    ts.ok (! wjson::decode_datetime ("1900-02-29", t), "decode not leap day");
+    ts.ok (! wjson::decode_datetime ("1979-13-01", t), "decode month 13");
+    ts.ok (! wjson::decode_datetime ("1979-05-27T24:00:00Z", t), "decode hour 24");
+    ts.ok (! wjson::decode_datetime ("1979-05-27T07:32:00.Z", t), "decode empty fraction");
+    ts.ok (! wjson::decode_datetime ("1979-05-27T07:32:00+07", t), "decode short offset");
+}
+
+void
+test_encode (test::simple& ts)
+{
+    char const* const canonical[] = {
+        "1979-05-27T07:32:00Z",
+        "1979-05-27T00:32:00-07:00",
+        "1979-05-27T00:32:00.999999-07:00",
+        "1979-05-27T07:32:00",
+        "1979-05-27",
+        "0000-01-01T00:00:00+09:30",
+        "9999-12-31T23:59:59.123456789Z",
+    };
+    for (char const* s : canonical) {
+        wjson::datetime_type t;
+        ts.ok (wjson::decode_datetime (s, t) && wjson::encode_datetime (t) == s,
+            std::string ("encode ") + s);
+    }
+    wjson::datetime_type t;
+    wjson::decode_datetime ("1979-05-27T07:32:00.500+00:00", t);
+    ts.ok (wjson::encode_datetime (t) == "1979-05-27T07:32:00.5Z", "encode canonical");
+}
+
+void
+test_compare (test::simple& ts)
+{
+    wjson::datetime_type a, b, c;
+    wjson::decode_datetime ("1979-05-27T07:32:00Z", a);
+    wjson::decode_datetime ("1979-05-27T00:32:00-07:00", b);
+    wjson::decode_datetime ("1979-05-27T07:32:00.000001Z", c);
+    ts.ok (wjson::same_instant (a, b) && ! wjson::earlier_instant (a, b)
+        && ! wjson::earlier_instant (b, a), "compare same instant");
+    ts.ok (a != b && (a < b) != (b < a), "compare offsets of same instant");
+    ts.ok (a < c && a != c && wjson::earlier_instant (a, c), "compare nanosecond");
+    wjson::datetime_type d, e;
+    wjson::decode_datetime ("1979-05-27", d);
+    wjson::decode_datetime ("1979-05-27T00:00:00Z", e);
+    ts.ok (wjson::same_instant (d, e) && d != e && (d < e || e < d),
+        "compare forms of same instant");
+}
+
+int
+main ()
+{
+    test::simple ts (23);
+
+    test_decode (ts);
+    test_encode (ts);
+    test_compare (ts);
+
+    return ts.done_testing ();
+}
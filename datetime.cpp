@@ -0,0 +1,158 @@
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include "datetime.hpp"
+
+namespace wjson {
+
+static bool scan_digits (std::string const& str, std::size_t const pos,
+    std::size_t const n, int& x);
+static int64_t days_from_civil (int64_t y, int const m, int const d);
+static void civil_from_days (int64_t z, int64_t& y, int& m, int& d);
+static int days_in_month (int64_t const y, int const m);
+
+bool
+decode_datetime (std::string const& str, datetime_type& dt)
+{
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    if (str.size () < 10 || str[4] != '-' || str[7] != '-'
+            || ! scan_digits (str, 0, 4, year)
+            || ! scan_digits (str, 5, 2, month)
+            || ! scan_digits (str, 8, 2, day))
+        return false;
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month (year, month))
+        return false;
+    datetime_type t {0, 0, 0, DATE_LOCAL};
+    std::size_t pos = 10;
+    if (pos < str.size ()) {
+        if (str.size () < 19 || str[10] != 'T' || str[13] != ':' || str[16] != ':'
+                || ! scan_digits (str, 11, 2, hour)
+                || ! scan_digits (str, 14, 2, minute)
+                || ! scan_digits (str, 17, 2, second))
+            return false;
+        if (hour > 23 || minute > 59 || second > 59)
+            return false;
+        t.mform = DATETIME_LOCAL;
+        pos = 19;
+        if (pos < str.size () && str[pos] == '.') {
+            std::size_t const first = ++pos;
+            int32_t scale = 100000000;
+            for (; pos < str.size () && '0' <= str[pos] && str[pos] <= '9'; ++pos) {
+                t.mnanosecond += (str[pos] - '0') * scale;
+                scale /= 10;
+            }
+            if (pos == first)
+                return false;
+        }
+        if (pos < str.size () && str[pos] == 'Z') {
+            t.mform = DATETIME_OFFSET;
+            ++pos;
+        }
+        else if (pos < str.size () && (str[pos] == '+' || str[pos] == '-')) {
+            int oh, om;
+            if (str.size () < pos + 6 || str[pos + 3] != ':'
+                    || ! scan_digits (str, pos + 1, 2, oh)
+                    || ! scan_digits (str, pos + 4, 2, om))
+                return false;
+            if (oh > 23 || om > 59)
+                return false;
+            t.moffset = (str[pos] == '-' ? -1 : 1) * (oh * 60 + om);
+            t.mform = DATETIME_OFFSET;
+            pos += 6;
+        }
+        if (pos != str.size ())
+            return false;
+    }
+    t.mseconds = days_from_civil (year, month, day) * 86400
+        + hour * 3600 + minute * 60 + second - t.moffset * 60;
+    dt = t;
+    return true;
+}
+
+std::string
+encode_datetime (datetime_type const& dt)
+{
+    int64_t const local = dt.mseconds + dt.moffset * 60;
+    int64_t days = local / 86400;
+    int64_t secs = local % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        --days;
+    }
+    int64_t year;
+    int month, day;
+    civil_from_days (days, year, month, day);
+    char buf[64];
+    std::snprintf (buf, sizeof (buf), "%04lld-%02d-%02d",
+        static_cast<long long> (year), month, day);
+    std::string out (buf);
+    if (dt.mform == DATE_LOCAL)
+        return out;
+    std::snprintf (buf, sizeof (buf), "T%02d:%02d:%02d",
+        static_cast<int> (secs / 3600), static_cast<int> (secs / 60 % 60),
+        static_cast<int> (secs % 60));
+    out += buf;
+    if (dt.mnanosecond > 0) {
+        std::snprintf (buf, sizeof (buf), ".%09d", static_cast<int> (dt.mnanosecond));
+        std::string frac (buf);
+        out += frac.substr (0, frac.find_last_not_of ('0') + 1);
+    }
+    if (dt.mform == DATETIME_LOCAL)
+        return out;
+    if (dt.moffset == 0)
+        return out + "Z";
+    int const offset = dt.moffset < 0 ? -dt.moffset : dt.moffset;
+    std::snprintf (buf, sizeof (buf), "%c%02d:%02d",
+        dt.moffset < 0 ? '-' : '+', offset / 60, offset % 60);
+    return out + buf;
+}
+
+static bool
+scan_digits (std::string const& str, std::size_t const pos,
+    std::size_t const n, int& x)
+{
+    x = 0;
+    for (std::size_t i = pos; i < pos + n; ++i) {
+        if (i >= str.size () || str[i] < '0' || '9' < str[i])
+            return false;
+        x = x * 10 + (str[i] - '0');
+    }
+    return true;
+}
+
+static int
+days_in_month (int64_t const y, int const m)
+{
+    static const int DAYS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m == 2 && y % 4 == 0 && (y % 100 != 0 || y % 400 == 0))
+        return 29;
+    return DAYS[m - 1];
+}
+
+// days from 1970-01-01 in the proleptic Gregorian calendar.
+static int64_t
+days_from_civil (int64_t y, int const m, int const d)
+{
+    y -= m <= 2;
+    int64_t const era = (y >= 0 ? y : y - 399) / 400;
+    int64_t const yoe = y - era * 400;
+    int64_t const doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void
+civil_from_days (int64_t z, int64_t& y, int& m, int& d)
+{
+    z += 719468;
+    int64_t const era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t const doe = z - era * 146097;
+    int64_t const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t const mp = (5 * doy + 2) / 153;
+    d = static_cast<int> (doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int> (mp < 10 ? mp + 3 : mp - 9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+}//namespace wjson
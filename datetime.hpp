@@ -0,0 +1,78 @@
+#pragma once
+
+/* datetime_type is a TOML datetime parsed once into numbers.
+ *
+ * mseconds counts seconds from 1970-01-01T00:00:00Z for DATETIME_OFFSET,
+ * and from 1970-01-01T00:00:00 on the wall clock for the local forms.
+ * moffset is minutes east of UTC and is 0 for the local forms.
+ * == and < look at the form and the offset as well, so that
+ * 1979-05-27 differs from 1979-05-27T00:00:00Z. same_instant and
+ * earlier_instant look at mseconds and mnanosecond only, so that
+ * the local forms compare as if they were in UTC.
+ *
+ *      wjson::datetime_type t;
+ *      if (wjson::decode_datetime ("1979-05-27T00:32:00-07:00", t))
+ *          std::cout << wjson::encode_datetime (t);  // same text
+ */
+
+#include <cstdint>
+#include <string>
+
+namespace wjson {
+
+enum datetime_form {
+    DATETIME_OFFSET,    // 1979-05-27T07:32:00Z, 1979-05-27T00:32:00-07:00
+    DATETIME_LOCAL,     // 1979-05-27T07:32:00
+    DATE_LOCAL,         // 1979-05-27
+};
+
+struct datetime_type {
+    int64_t mseconds;
+    int32_t mnanosecond;
+    int16_t moffset;
+    datetime_form mform;
+};
+
+// parses RFC 3339 forms of TOML v0.4.0 with year 0000 to 9999.
+// fraction digits after the ninth are dropped.
+bool decode_datetime (std::string const& str, datetime_type& dt);
+
+// writes the canonical form: fraction without trailing zeros,
+// and Z for the zero offset.
+std::string encode_datetime (datetime_type const& dt);
+
+inline bool
+same_instant (datetime_type const& a, datetime_type const& b)
+{
+    return a.mseconds == b.mseconds && a.mnanosecond == b.mnanosecond;
+}
+
+inline bool
+earlier_instant (datetime_type const& a, datetime_type const& b)
+{
+    return a.mseconds < b.mseconds
+        || (a.mseconds == b.mseconds && a.mnanosecond < b.mnanosecond);
+}
+
+// orders by the instant, then by the form and the offset.
+inline bool
+operator< (datetime_type const& a, datetime_type const& b)
+{
+    if (! same_instant (a, b))
+        return earlier_instant (a, b);
+    return a.mform < b.mform || (a.mform == b.mform && a.moffset < b.moffset);
+}
+
+inline bool
+operator== (datetime_type const& a, datetime_type const& b)
+{
+    return same_instant (a, b) && a.mform == b.mform && a.moffset == b.moffset;
+}
+
+inline bool
+operator!= (datetime_type const& a, datetime_type const& b)
+{
+    return ! (a == b);
+}
+
+}//namespace wjson
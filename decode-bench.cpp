@@ -0,0 +1,103 @@
+#include <string>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include "value.hpp"
+#include "json.hpp"
+#include "toml.hpp"
+#include "yaml.hpp"
+
+// decode and teardown time of a synthetic document.
+//
+//      decode-bench [json|toml|yaml] [megabytes]
+//          containers with std::allocator
+//      decode-arena-bench [json|toml|yaml] [megabytes]
+//          containers with arena_allocator (-DWJSON_ARENA)
+
+static std::string
+make_input (std::string const& format, std::size_t const size)
+{
+    std::string str (format == "json" ? "[" : "");
+    for (std::size_t i = 0; str.size () < size; ++i) {
+        std::string const n = std::to_string (i);
+        if (format == "json")
+            str += (i > 0 ? "," : "") + std::string ("{\"id\":") + n
+                + ",\"name\":\"item " + n + "\","
+                "\"tags\":[\"alpha\",\"beta\",\"gamma\"],"
+                "\"score\":" + n + ".25,\"ok\":true,\"next\":null}";
+        else if (format == "toml")
+            str += "[[item]]\nid = " + n + "\nname = \"item " + n + "\"\n"
+                "tags = [\"alpha\", \"beta\", \"gamma\"]\n"
+                "score = " + n + ".25\nok = true\n";
+        else
+            str += "- {id: " + n + ", name: item " + n + ", "
+                "tags: [alpha, beta, gamma], "
+                "score: " + n + ".25, ok: true, next: null}\n";
+    }
+    if (format == "json")
+        str += "]";
+    return str;
+}
+
+template<typename T>
+static bool
+decode (std::string const& format, std::string const& input, T& root)
+{
+    if (format == "json")
+        return wjson::decode_json (input, root);
+    else if (format == "toml")
+        return wjson::decode_toml (input, root);
+    else
+        return wjson::decode_yaml (input, root) != std::string::npos;
+}
+
+static double
+msec (std::chrono::steady_clock::time_point const t0,
+    std::chrono::steady_clock::time_point const t1)
+{
+    return std::chrono::duration<double, std::milli> (t1 - t0).count ();
+}
+
+int
+main (int argc, char* argv[])
+{
+    std::string const format = argc > 1 ? argv[1] : "json";
+    std::size_t const megabytes = argc > 2 ? std::atol (argv[2]) : 100;
+    if (format != "json" && format != "toml" && format != "yaml") {
+        std::cerr << "usage: " << argv[0] << " [json|toml|yaml] [megabytes]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string const input = make_input (format, megabytes * 1024 * 1024);
+#if defined (WJSON_ARENA)
+    std::cout << "allocator: arena_allocator" << std::endl;
+#else
+    std::cout << "allocator: std::allocator" << std::endl;
+#endif
+    std::cout << "input: " << format << " " << input.size () << " bytes"
+              << std::endl;
+
+    auto t0 = std::chrono::steady_clock::now ();
+    std::unique_ptr<wjson::value_type> value (new wjson::value_type);
+    bool const ok1 = decode (format, input, *value);
+    auto t1 = std::chrono::steady_clock::now ();
+    value.reset ();
+    auto t2 = std::chrono::steady_clock::now ();
+    std::cout << "value_type    decode " << msec (t0, t1) << " ms"
+              << ", release " << msec (t1, t2) << " ms"
+              << (ok1 ? "" : " (decode failed)") << std::endl;
+
+    t0 = std::chrono::steady_clock::now ();
+    std::unique_ptr<wjson::document_type> doc (new wjson::document_type);
+    bool const ok2 = decode (format, input, *doc);
+    t1 = std::chrono::steady_clock::now ();
+    std::size_t const arena_size = doc->arena ().capacity ();
+    doc.reset ();
+    t2 = std::chrono::steady_clock::now ();
+    std::cout << "document_type decode " << msec (t0, t1) << " ms"
+              << ", release " << msec (t1, t2) << " ms"
+              << ", arena " << arena_size << " bytes"
+              << (ok2 ? "" : " (decode failed)") << std::endl;
+    return ok1 && ok2 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
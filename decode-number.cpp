@@ -0,0 +1,162 @@
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include "decode-number.hpp"
+
+namespace wjson {
+
+// a decimal literal as mantissa * 10^exponent.
+struct decimal_type {
+    uint64_t mmantissa;
+    int mexponent;
+    bool mnegative;
+    bool mintegral;     // without fraction and exponent
+    bool mexact;        // no significant digit dropped
+};
+
+static bool split_decimal (char const* s, char const* const e, decimal_type& x);
+static char const* terminate (char const* const s, char const* const e,
+    char (&buf)[64], std::string& big);
+
+bool
+decode_fixnum (char const* const first, char const* const last, int64_t& x,
+    int const base)
+{
+    static const uint64_t LIMIT = static_cast<uint64_t> (INT64_MAX);
+    decimal_type d;
+    if (base == 10 && split_decimal (first, last, d) && d.mintegral && d.mexact
+            && d.mexponent == 0) {
+        if (d.mmantissa > LIMIT + (d.mnegative ? 1 : 0))
+            return false;
+        x = d.mnegative ? static_cast<int64_t> (0 - d.mmantissa)
+            : static_cast<int64_t> (d.mmantissa);
+        return true;
+    }
+    char buf[64];
+    std::string big;
+    char const* const s = terminate (first, last, buf, big);
+    char* e = nullptr;
+    errno = 0;
+    long long const n = std::strtoll (s, &e, base);
+    if (e == s || errno == ERANGE)
+        return false;
+    x = n;
+    return true;
+}
+
+// Clinger's fast path: a mantissa below 2^53 and a power of ten
+// up to 10^22 are exact doubles, so that one rounding gives
+// the nearest double. the others go to strtod.
+bool
+decode_flonum (char const* const first, char const* const last, double& x)
+{
+    static const double POW10[23] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    static const uint64_t MANTISSA_LIMIT = uint64_t (1) << 53;
+    decimal_type d;
+    if (split_decimal (first, last, d) && d.mexact) {
+        uint64_t w = d.mmantissa;
+        int exponent = d.mexponent;
+        // moves digits from a large exponent into the mantissa.
+        while (exponent > 22 && w != 0 && w < MANTISSA_LIMIT / 10) {
+            w *= 10;
+            --exponent;
+        }
+        if (w == 0) {
+            x = d.mnegative ? -0.0 : 0.0;
+            return true;
+        }
+        if (w < MANTISSA_LIMIT && -22 <= exponent && exponent <= 22) {
+            double y = static_cast<double> (w);
+            if (exponent < 0)
+                y /= POW10[-exponent];
+            else
+                y *= POW10[exponent];
+            x = d.mnegative ? -y : y;
+            return true;
+        }
+    }
+    char buf[64];
+    std::string big;
+    char const* const s = terminate (first, last, buf, big);
+    char* e = nullptr;
+    errno = 0;
+    double const y = std::strtod (s, &e);
+    if (e == s || errno == ERANGE)
+        return false;
+    x = y;
+    return true;
+}
+
+// matches [-+]?[0-9]+(\.[0-9]+)?([eE][-+]?[0-9]+)? as a whole.
+static bool
+split_decimal (char const* s, char const* const e, decimal_type& x)
+{
+    x = decimal_type {0, 0, false, true, true};
+    if (s < e && (*s == '-' || *s == '+'))
+        x.mnegative = *s++ == '-';
+    int ndigit = 0;
+    int nsignificant = 0;
+    bool fraction = false;
+    for (; s < e; ++s) {
+        if (*s == '.' && ! fraction && ndigit > 0) {
+            fraction = true;
+            x.mintegral = false;
+            if (s + 1 == e || *(s + 1) < '0' || '9' < *(s + 1))
+                return false;
+            continue;
+        }
+        if (*s < '0' || '9' < *s)
+            break;
+        ++ndigit;
+        int const digit = *s - '0';
+        if (nsignificant == 0 && digit == 0)
+            x.mexponent -= fraction ? 1 : 0;
+        else if (nsignificant < 19) {
+            x.mmantissa = x.mmantissa * 10 + digit;
+            ++nsignificant;
+            x.mexponent -= fraction ? 1 : 0;
+        }
+        else {
+            x.mexact = x.mexact && digit == 0;
+            x.mexponent += fraction ? 0 : 1;
+        }
+    }
+    if (ndigit == 0)
+        return false;
+    if (s < e && (*s == 'e' || *s == 'E')) {
+        x.mintegral = false;
+        bool negative = false;
+        if (++s < e && (*s == '-' || *s == '+'))
+            negative = *s++ == '-';
+        if (s == e)
+            return false;
+        int exponent = 0;
+        for (; s < e && '0' <= *s && *s <= '9'; ++s)
+            if (exponent < 100000)
+                exponent = exponent * 10 + (*s - '0');
+        x.mexponent += negative ? -exponent : exponent;
+    }
+    return s == e;
+}
+
+// strtoll and strtod want a terminated copy.
+static char const*
+terminate (char const* const s, char const* const e,
+    char (&buf)[64], std::string& big)
+{
+    std::size_t const n = e - s;
+    if (n < sizeof (buf)) {
+        std::memcpy (buf, s, n);
+        buf[n] = '\0';
+        return buf;
+    }
+    big.assign (s, e);
+    return big.c_str ();
+}
+
+}//namespace wjson
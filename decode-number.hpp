@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace wjson {
+
+// convert number literals matched by the scanners without exceptions.
+// they fail on an empty literal and on the overflow or underflow.
+// a decimal literal of up to 19 significant digits converts without
+// allocation; the others go to strtoll and strtod.
+bool decode_fixnum (char const* first, char const* last, int64_t& x,
+    int const base = 10);
+bool decode_flonum (char const* first, char const* last, double& x);
+
+inline bool
+decode_fixnum (std::string const& literal, int64_t& x, int const base = 10)
+{
+    return decode_fixnum (literal.data (), literal.data () + literal.size (),
+        x, base);
+}
+
+inline bool
+decode_flonum (std::string const& literal, double& x)
+{
+    return decode_flonum (literal.data (), literal.data () + literal.size (), x);
+}
+
+}//namespace wjson
@@ -0,0 +1,110 @@
+#include "diff.hpp"
+#include "json.hpp"
+#include "taptests.hpp"
+#include <string>
+
+static wjson::value_type
+json (std::string const& input)
+{
+    wjson::value_type x;
+    wjson::decode_json (input, x);
+    return x;
+}
+
+void
+test_diff_equal (test::simple& ts)
+{
+    wjson::value_type a = json (R"q({"a":1,"b":[1,2],"c":{"d":"x"}})q");
+    wjson::value_type b = json (R"q({"c":{"d":"x"},"b":[1,2],"a":1})q");
+    ts.ok (wjson::diff (a, b).empty (), "diff equal trees");
+}
+
+void
+test_diff_table (test::simple& ts)
+{
+    wjson::value_type a = json (R"q({"a":1,"b":{"c":2,"d":3},"e/f":4})q");
+    wjson::value_type b = json (R"q({"b":{"c":2,"d":5,"g":6},"e/f":4,"h":null})q");
+    wjson::patch_list_type patch = wjson::diff (a, b);
+    ts.ok (patch.size () == 4, "diff table size");
+    ts.ok (patch[0].mop == wjson::PATCH_REMOVE && patch[0].mpath == L"/a",
+        "diff table remove");
+    ts.ok (patch[1].mop == wjson::PATCH_REPLACE && patch[1].mpath == L"/b/d"
+        && patch[1].mvalue.fixnum () == 5, "diff table replace");
+    ts.ok (patch[2].mop == wjson::PATCH_ADD && patch[2].mpath == L"/b/g"
+        && patch[3].mpath == L"/h", "diff table add");
+    wjson::apply_patch (a, std::move (patch));
+    ts.ok (a == b, "apply table patch");
+}
+
+void
+test_diff_datetime (test::simple& ts)
+{
+    wjson::datetime_type t, u;
+    wjson::decode_datetime ("1979-05-27T07:32:00Z", t);
+    wjson::decode_datetime ("1979-05-27T00:32:00-07:00", u);
+    wjson::value_type a = wjson::table ();
+    wjson::value_type b = wjson::table ();
+    a.set (L"d", wjson::datetime (t));
+    b.set (L"d", wjson::datetime (u));
+    wjson::patch_list_type patch = wjson::diff (a, b);
+    ts.ok (patch.size () == 1 && patch[0].mop == wjson::PATCH_REPLACE
+        && patch[0].mpath == L"/d", "diff datetime offset");
+}
+
+void
+test_diff_array (test::simple& ts)
+{
+    wjson::value_type a = json (R"q({"x":[1,2,3,4],"y":[1],"z":[true]})q");
+    wjson::value_type b = json (R"q({"x":[1,5],"y":[1,2,3],"z":"s"})q");
+    wjson::patch_list_type patch = wjson::diff (a, b);
+    ts.ok (patch.size () == 6, "diff array size");
+    ts.ok (patch[1].mop == wjson::PATCH_REMOVE && patch[1].mpath == L"/x/3"
+        && patch[2].mpath == L"/x/2", "diff array removes from the last");
+    ts.ok (patch[5].mop == wjson::PATCH_REPLACE && patch[5].mpath == L"/z",
+        "diff replaces other types");
+    wjson::value_type packed;
+    wjson::decode_json (R"q({"x":[1,2,3,4],"y":[1],"z":[true]})q", packed,
+        wjson::DECODE_PACK_ARRAY);
+    ts.ok (wjson::diff (packed, b).size () == 6, "diff packed arrays");
+    wjson::apply_patch (packed, std::move (patch));
+    ts.ok (packed == b, "apply array patch");
+}
+
+void
+test_apply (test::simple& ts)
+{
+    wjson::value_type a = json (R"q({"list":[1,3]})q");
+    wjson::patch_list_type patch;
+    patch.push_back ({wjson::PATCH_ADD, L"/list/1", wjson::fixnum (2)});
+    patch.push_back ({wjson::PATCH_ADD, L"/list/-", wjson::fixnum (4)});
+    patch.push_back ({wjson::PATCH_ADD, L"/m~1n", wjson::string (L"t")});
+    wjson::apply_patch (a, std::move (patch));
+    ts.ok (a == json (R"q({"list":[1,2,3,4],"m/n":"t"})q"), "apply add");
+    bool thrown = false;
+    try {
+        patch.clear ();
+        patch.push_back ({wjson::PATCH_REPLACE, L"/none", wjson::null ()});
+        wjson::apply_patch (a, std::move (patch));
+    }
+    catch (std::out_of_range const&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "apply throws on missing path");
+    wjson::value_type doc = wjson::encode_patch (wjson::diff (a, json ("[]")));
+    ts.ok (wjson::encode_json (doc) == R"q([{"op":"replace","path":"","value":[]}])q",
+        "encode patch");
+}
+
+int
+main ()
+{
+    test::simple ts (15);
+
+    test_diff_equal (ts);
+    test_diff_table (ts);
+    test_diff_datetime (ts);
+    test_diff_array (ts);
+    test_apply (ts);
+
+    return ts.done_testing ();
+}
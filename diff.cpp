@@ -0,0 +1,257 @@
+#include <vector>
+#include <string>
+#include <utility>
+#include <stdexcept>
+#include <cstring>
+#include "diff.hpp"
+
+namespace wjson {
+
+static void diff_value (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch);
+static void diff_table (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch);
+static void diff_array (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch);
+
+patch_list_type
+diff (value_type const& from, value_type const& to)
+{
+    patch_list_type patch;
+    string_type path;
+    diff_value (from, to, path, patch);
+    return patch;
+}
+
+// append a reference token with ~0 and ~1 escapes.
+static void
+push_token (string_type& path, char_type const* p, std::size_t const n)
+{
+    path.push_back ('/');
+    for (std::size_t i = 0; i < n; ++i) {
+        if (p[i] == '~')
+            path.append ({'~', '0'});
+        else if (p[i] == '/')
+            path.append ({'~', '1'});
+        else
+            path.push_back (p[i]);
+    }
+}
+
+static void
+push_index (string_type& path, std::size_t const idx)
+{
+    path.push_back ('/');
+    std::size_t const first = path.size ();
+    for (std::size_t x = idx; ; x /= 10) {
+        path.insert (path.begin () + first, static_cast<char_type> ('0' + x % 10));
+        if (x < 10)
+            break;
+    }
+}
+
+static void
+emit (patch_list_type& patch, patch_op const op, string_type const& path,
+    value_type const& x)
+{
+    patch.push_back ({op, path, x});
+}
+
+static void
+diff_value (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch)
+{
+    if (from.tag () == VALUE_TABLE && to.tag () == VALUE_TABLE)
+        diff_table (from, to, path, patch);
+    else if (from.tag () == VALUE_ARRAY && to.tag () == VALUE_ARRAY)
+        diff_array (from, to, path, patch);
+    else if (from != to)
+        emit (patch, PATCH_REPLACE, path, to);
+}
+
+// merge join of entries in the key order.
+static void
+diff_table (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch)
+{
+    table_entries_type const a = sorted_entries (from.table ());
+    table_entries_type const b = sorted_entries (to.table ());
+    std::size_t const size = path.size ();
+    auto i = a.cbegin ();
+    auto j = b.cbegin ();
+    while (i != a.cend () || j != b.cend ()) {
+        if (j == b.cend () || (i != a.cend () && (*i)->first < (*j)->first)) {
+            push_token (path, (*i)->first.data (), (*i)->first.size ());
+            emit (patch, PATCH_REMOVE, path, value_type ());
+            ++i;
+        }
+        else if (i == a.cend () || (*j)->first < (*i)->first) {
+            push_token (path, (*j)->first.data (), (*j)->first.size ());
+            emit (patch, PATCH_ADD, path, (*j)->second);
+            ++j;
+        }
+        else {
+            push_token (path, (*i)->first.data (), (*i)->first.size ());
+            diff_value ((*i)->second, (*j)->second, path, patch);
+            ++i;
+            ++j;
+        }
+        path.resize (size);
+    }
+}
+
+// an element of an array, made into a value when the array is packed.
+static value_type const&
+element (value_type const& x, std::size_t const i, value_type& tmp)
+{
+    switch (x.packed ()) {
+    case PACK_BOOLEAN: tmp = ::wjson::boolean (x.booleans ()[i]); return tmp;
+    case PACK_FIXNUM: tmp = ::wjson::fixnum (x.fixnums ()[i]); return tmp;
+    case PACK_FLONUM: tmp = ::wjson::flonum (x.flonums ()[i]); return tmp;
+    default: return x.array ()[i];
+    }
+}
+
+static void
+diff_array (value_type const& from, value_type const& to,
+    string_type& path, patch_list_type& patch)
+{
+    std::size_t const size = path.size ();
+    std::size_t const n = from.size ();
+    std::size_t const m = to.size ();
+    value_type a, b;
+    for (std::size_t i = 0; i < n || i < m; ++i) {
+        if (i >= n) {
+            push_index (path, i);
+            emit (patch, PATCH_ADD, path, element (to, i, b));
+        }
+        else if (i < m) {
+            push_index (path, i);
+            diff_value (element (from, i, a), element (to, i, b), path, patch);
+        }
+        path.resize (size);
+    }
+    for (std::size_t i = n; i > m; --i) {
+        push_index (path, i - 1);
+        emit (patch, PATCH_REMOVE, path, value_type ());
+        path.resize (size);
+    }
+}
+
+// split a JSON Pointer into unescaped reference tokens.
+static std::vector<string_type>
+split_pointer (string_type const& str)
+{
+    std::vector<string_type> tokens;
+    if (str.empty ())
+        return tokens;
+    if (str[0] != '/')
+        throw std::out_of_range ("apply_patch(): invalid path");
+    string_type token;
+    for (std::size_t i = 1; i <= str.size (); ++i) {
+        if (i == str.size () || str[i] == '/') {
+            tokens.push_back (std::move (token));
+            token.clear ();
+        }
+        else if (str[i] != '~')
+            token.push_back (str[i]);
+        else if (i + 1 < str.size () && (str[i + 1] == '0' || str[i + 1] == '1'))
+            token.push_back (str[++i] == '0' ? '~' : '/');
+        else
+            throw std::out_of_range ("apply_patch(): invalid escape");
+    }
+    return tokens;
+}
+
+// an array index of digits, or the size of the array for "-".
+static std::size_t
+array_index (value_type const& array, string_type const& token)
+{
+    if (token.size () == 1 && token[0] == '-')
+        return array.size ();
+    if (token.empty () || token.size () > 18 || (token.size () > 1 && token[0] == '0'))
+        throw std::out_of_range ("apply_patch(): invalid index");
+    std::size_t idx = 0;
+    for (char_type const c : token) {
+        if (c < '0' || '9' < c)
+            throw std::out_of_range ("apply_patch(): invalid index");
+        idx = idx * 10 + (c - '0');
+    }
+    return idx;
+}
+
+static void
+apply_op (value_type& root, patch_type& op)
+{
+    std::vector<string_type> const tokens = split_pointer (op.mpath);
+    if (tokens.empty ()) {
+        if (op.mop == PATCH_REMOVE)
+            root = value_type ();
+        else
+            root = std::move (op.mvalue);
+        return;
+    }
+    value_type* node = &root;
+    for (std::size_t i = 0; i + 1 < tokens.size (); ++i) {
+        node = node->tag () == VALUE_ARRAY ? node->find (array_index (*node, tokens[i]))
+            : node->find (tokens[i]);
+        if (node == nullptr)
+            throw std::out_of_range ("apply_patch(): path not found");
+    }
+    string_type const& last = tokens.back ();
+    if (node->tag () == VALUE_TABLE) {
+        bool const found = node->find (last) != nullptr;
+        if (op.mop == PATCH_REMOVE && found)
+            node->table ().erase (key_type::view (last));
+        else if (op.mop == PATCH_ADD || (op.mop == PATCH_REPLACE && found))
+            node->set (last, std::move (op.mvalue));
+        else
+            throw std::out_of_range ("apply_patch(): path not found");
+    }
+    else if (node->tag () == VALUE_ARRAY) {
+        std::size_t const idx = array_index (*node, last);
+        array_value_type& array = node->array ();
+        if (op.mop == PATCH_ADD && idx <= array.size ())
+            array.insert (array.begin () + idx, std::move (op.mvalue));
+        else if (op.mop == PATCH_REMOVE && idx < array.size ())
+            array.erase (array.begin () + idx);
+        else if (op.mop == PATCH_REPLACE && idx < array.size ())
+            array[idx] = std::move (op.mvalue);
+        else
+            throw std::out_of_range ("apply_patch(): path not found");
+    }
+    else
+        throw std::out_of_range ("apply_patch(): path not found");
+}
+
+void
+apply_patch (value_type& root, patch_list_type&& patch)
+{
+    for (auto& op : patch)
+        apply_op (root, op);
+}
+
+// an ASCII name in string_type of either encoding.
+static string_type
+ascii (char const* const s)
+{
+    return string_type (s, s + std::strlen (s));
+}
+
+value_type
+encode_patch (patch_list_type const& patch)
+{
+    static char const* const NAME[] = {"add", "remove", "replace"};
+    value_type doc = ::wjson::array ();
+    doc.reserve (patch.size ());
+    for (auto const& op : patch) {
+        value_type& x = doc.emplace_back (::wjson::table ());
+        x.set (ascii ("op"), ::wjson::string (ascii (NAME[op.mop])));
+        x.set (ascii ("path"), ::wjson::string (op.mpath));
+        if (op.mop != PATCH_REMOVE)
+            x.set (ascii ("value"), op.mvalue);
+    }
+    return doc;
+}
+
+}//namespace wjson
@@ -0,0 +1,46 @@
+#pragma once
+
+/* diff and patch of value_type trees in RFC 6902 JSON Patch operations.
+ *
+ *      wjson::patch_list_type patch = wjson::diff (old_config, new_config);
+ *      for (auto const& op : patch)
+ *          reload (op.mpath);                      // "/server/port" and so on
+ *      wjson::apply_patch (old_config, std::move (patch));
+ *
+ * diff emits add, remove and replace with JSON Pointer paths.
+ * it walks both trees once, joining tables in the key order,
+ * and compares the leaves at the same paths.
+ * array elements are compared by positions; extra elements are added
+ * at the end, or removed from the last one.
+ */
+
+#include <vector>
+#include "value.hpp"
+
+namespace wjson {
+
+enum patch_op {
+    PATCH_ADD,
+    PATCH_REMOVE,
+    PATCH_REPLACE,
+};
+
+struct patch_type {
+    patch_op mop;
+    string_type mpath;
+    value_type mvalue;      // null for PATCH_REMOVE
+};
+
+typedef std::vector<patch_type> patch_list_type;
+
+patch_list_type diff (value_type const& from, value_type const& to);
+
+// apply_patch moves values out of the operations into the tree.
+// it throws out_of_range on a path that does not exist, and leaves
+// the operations applied before it.
+void apply_patch (value_type& root, patch_list_type&& patch);
+
+// the JSON Patch document of operations, for encode_json.
+value_type encode_patch (patch_list_type const& patch);
+
+}//namespace wjson
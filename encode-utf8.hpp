@@ -3,10 +3,10 @@
 #include <ostream>
 #include <string>
 #include <cstdint>
+#include <utility>
 
 namespace wjson {
 
-bool decode_utf8 (std::string const& octets, std::wstring& str);
 bool encode_utf8 (std::wstring const& str, std::string& octets);
 
 static inline void
@@ -31,4 +31,99 @@ encode_utf8 (std::ostream& out, std::uint32_t const uc)
     }
 }
 
+// put a code unit of a string_type already in UTF-32 or UTF-8.
+static inline void
+encode_utf8 (std::ostream& out, wchar_t const c)
+{
+    encode_utf8 (out, static_cast<std::uint32_t> (c));
+}
+
+static inline void
+encode_utf8 (std::ostream& out, char const c)
+{
+    out.put (c);
+}
+
+// append a code point to a string_type in UTF-32 or UTF-8.
+template<typename A>
+inline void
+append_code (std::basic_string<wchar_t, std::char_traits<wchar_t>, A>& str,
+    std::uint32_t const uc)
+{
+    str.push_back (uc);
+}
+
+template<typename A>
+inline void
+append_code (std::basic_string<char, std::char_traits<char>, A>& str,
+    std::uint32_t const uc)
+{
+    if (uc < 0x80)
+        str.push_back (uc);
+    else if (uc < 0x800) {
+        str.push_back (((uc >>  6) & 0xff) | 0xc0);
+        str.push_back (( uc        & 0x3f) | 0x80);
+    }
+    else if (uc < 0x10000) {
+        str.push_back (((uc >> 12) & 0x0f) | 0xe0);
+        str.push_back (((uc >>  6) & 0x3f) | 0x80);
+        str.push_back (( uc        & 0x3f) | 0x80);
+    }
+    else if (uc < 0x110000) {
+        str.push_back (((uc >> 18) & 0x07) | 0xf0);
+        str.push_back (((uc >> 12) & 0x3f) | 0x80);
+        str.push_back (((uc >>  6) & 0x3f) | 0x80);
+        str.push_back (( uc        & 0x3f) | 0x80);
+    }
+}
+
+// decode octets into UTF-32 std::wstring or UTF-8 std::string,
+// or the string_type with any allocator.
+template<typename C, typename A>
+bool
+decode_utf8 (std::string const& octets,
+    std::basic_string<C, std::char_traits<C>, A>& str)
+{
+    static const std::uint32_t LOWERBOUND[5] = {0, 0, 0x80L, 0x0800L, 0x10000L};
+    static const std::uint32_t UPPERBOUND = 0x10ffffL;
+    std::basic_string<C, std::char_traits<C>, A> buf;
+    str.clear ();
+    int state = 1;
+    int length = 1;
+    std::uint32_t code = 0;
+    for (auto s = octets.cbegin (); state > 0 && s != octets.cend (); ++s) {
+        std::uint32_t octet = static_cast<unsigned char> (*s);
+        if (0 == (0x80U & octet)) {
+            length = state = (1 == state) ? 1 : 0;
+            code = octet;
+        }
+        else if (0xc0U == (0xe0U & octet)) {
+            length = state = (1 == state) ? 2 : 0;
+            code = 0x1f & octet;
+        }
+        else if (0xe0U == (0xf0U & octet)) {
+            length = state = (1 == state) ? 3 : 0;
+            code = 0x0f & octet;
+        }
+        else if (0xf0U == (0xf8U & octet)) {
+            length = state = (1 == state) ? 4 : 0;
+            code = 0x07 & octet;
+        }
+        else if (0x80U == (0xc0U & octet)) {
+            state = (1 < state) ? state - 1 : 0;
+            code = (code << 6) | (0x3f & octet);
+        }
+        if (1 == state) {
+            if (code < LOWERBOUND[length] || UPPERBOUND < code)
+                return false;
+            if (0xd800L <= code && code <= 0xdfffL)
+                return false;
+            append_code (buf, code);
+        }
+    }
+    if (1 == state)
+        std::swap (str, buf);
+    return 1 == state;
+}
+
 }//namespace wjson
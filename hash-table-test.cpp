@@ -0,0 +1,111 @@
+#include "hash-table.hpp"
+#include "taptests.hpp"
+#include <string>
+#include <map>
+
+void
+test_insert (test::simple& ts)
+{
+    wjson::hash_table<std::wstring,int> table;
+    ts.ok (table.empty (), "hash_table empty");
+    ts.ok (table.find (L"foo") == table.end (), "hash_table find miss empty");
+    table[L"foo"] = 1;
+    table[L"bar"] = 2;
+    ts.ok (table.size () == 2, "hash_table size 2");
+    ts.ok (table.count (L"foo") == 1, "hash_table count foo");
+    ts.ok (table.count (L"baz") == 0, "hash_table count baz");
+    ts.ok (table.at (L"bar") == 2, "hash_table at bar");
+    table[L"foo"] = 3;
+    ts.ok (table.size () == 2 && table.at (L"foo") == 3, "hash_table overwrite");
+    auto r = table.insert (std::make_pair (std::wstring (L"foo"), 4));
+    ts.ok (! r.second && r.first->second == 3, "hash_table insert existing");
+    r = table.insert (std::make_pair (std::wstring (L"baz"), 5));
+    ts.ok (r.second && table.at (L"baz") == 5, "hash_table insert new");
+    bool thrown = false;
+    try {
+        table.at (L"none");
+    }
+    catch (std::out_of_range&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "hash_table at throws out_of_range");
+    auto i = table.begin ();
+    ts.ok (i->first == L"foo" && (++i)->first == L"bar"
+        && (++i)->first == L"baz", "hash_table insertion order");
+}
+
+void
+test_grow_and_erase (test::simple& ts)
+{
+    wjson::hash_table<std::string,int> table;
+    std::map<std::string,int> expected;
+    for (int i = 0; i < 5000; ++i) {
+        std::string key = "key" + std::to_string (i * 7919 % 10007);
+        table[key] = i;
+        expected[key] = i;
+    }
+    bool same = table.size () == expected.size ();
+    for (auto& x : expected)
+        same = same && table.count (x.first) == 1 && table.at (x.first) == x.second;
+    ts.ok (same, "hash_table grow 5000 keys");
+    for (int i = 0; i < 5000; i += 3) {
+        std::string key = "key" + std::to_string (i * 7919 % 10007);
+        table.erase (key);
+        expected.erase (key);
+    }
+    ts.ok (table.erase ("none") == 0, "hash_table erase miss");
+    same = table.size () == expected.size ();
+    for (auto& x : expected)
+        same = same && table.count (x.first) == 1 && table.at (x.first) == x.second;
+    for (auto& x : table)
+        same = same && expected.count (x.first) == 1;
+    ts.ok (same, "hash_table erase every 3rd keys");
+    table.clear ();
+    ts.ok (table.empty () && table.count ("key0") == 0, "hash_table clear");
+}
+
+// counts calls to see whether lookups hash keys.
+struct counting_hash {
+    static int count;
+    std::size_t operator() (std::string const& s) const
+    {
+        ++count;
+        return std::hash<std::string> () (s);
+    }
+};
+
+int counting_hash::count = 0;
+
+void
+test_small (test::simple& ts)
+{
+    wjson::hash_table<std::string,int,counting_hash> table;
+    for (int i = 0; i < 8; ++i)
+        table["k" + std::to_string (i)] = i;
+    bool same = table.at ("k7") == 7 && table.count ("k8") == 0;
+    ts.ok (same && counting_hash::count == 0, "hash_table small without hashing");
+    table.erase ("k0");
+    ts.ok (table.size () == 7 && table.begin ()->first == "k7",
+        "hash_table small erase moves the last");
+    table["k0"] = 0;
+    table["k8"] = 8;
+    same = table.size () == 9 && counting_hash::count > 0;
+    for (int i = 0; i < 9; ++i)
+        same = same && table.at ("k" + std::to_string (i)) == i;
+    ts.ok (same, "hash_table promotes past small size");
+    auto i = table.end () - 2;
+    ts.ok (i->first == "k0" && (++i)->first == "k8",
+        "hash_table keeps order on promotion");
+}
+
+int
+main ()
+{
+    test::simple ts (19);
+
+    test_insert (ts);
+    test_grow_and_erase (ts);
+    test_small (ts);
+
+    return ts.done_testing ();
+}
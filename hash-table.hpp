@@ -0,0 +1,275 @@
+#pragma once
+
+/* open addressing hash table with a subset of std::map interface.
+ *
+ * entries are kept in a dense vector in insertion order, and an index
+ * of power of two slots refers them by linear probing. each slot holds
+ * the 32 bits key hash and the entry position plus one (zero is empty),
+ * so that probing compares the stored hash before the key, and growing
+ * the index never rehashes keys.
+ *
+ * a table of up to SMALL_SIZE entries has no index, and lookups
+ * compare keys along the entries without hashing them. inserting
+ * past SMALL_SIZE entries builds the index.
+ *
+ * erase moves the last entry into the hole, so that it changes
+ * the iteration order.
+ */
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+
+namespace wjson {
+
+template<typename K, typename T, typename H = std::hash<K>,
+    typename E = std::equal_to<K>, typename A = std::allocator<std::pair<K,T>>>
+class hash_table {
+public:
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::pair<K,T> value_type;
+    typedef std::size_t size_type;
+    typedef typename std::vector<value_type,A>::iterator iterator;
+    typedef typename std::vector<value_type,A>::const_iterator const_iterator;
+    enum { SMALL_SIZE = 8 };
+
+    hash_table () : mentry (), mslot () {}
+
+    iterator begin () { return mentry.begin (); }
+    iterator end () { return mentry.end (); }
+    const_iterator begin () const { return mentry.cbegin (); }
+    const_iterator end () const { return mentry.cend (); }
+    const_iterator cbegin () const { return mentry.cbegin (); }
+    const_iterator cend () const { return mentry.cend (); }
+    size_type size () const { return mentry.size (); }
+    bool empty () const { return mentry.empty (); }
+    size_type capacity () const { return mentry.capacity (); }
+    std::size_t index_bytes () const { return mslot.capacity () * sizeof (slot_type); }
+
+    void
+    clear ()
+    {
+        mentry.clear ();
+        mslot.clear ();
+    }
+
+    void
+    reserve (size_type const n)
+    {
+        mentry.reserve (n);
+        if (n > SMALL_SIZE && n * 3 > mslot.size () * 2)
+            rehash (n);
+    }
+
+    iterator
+    find (K const& key)
+    {
+        std::size_t const i = locate (key);
+        return i < mentry.size () ? mentry.begin () + i : mentry.end ();
+    }
+
+    const_iterator
+    find (K const& key) const
+    {
+        std::size_t const i = locate (key);
+        return i < mentry.size () ? mentry.cbegin () + i : mentry.cend ();
+    }
+
+    size_type
+    count (K const& key) const
+    {
+        return locate (key) < mentry.size () ? 1 : 0;
+    }
+
+    T&
+    at (K const& key)
+    {
+        std::size_t const i = locate (key);
+        if (i >= mentry.size ())
+            throw std::out_of_range ("hash_table::at: no key");
+        return mentry[i].second;
+    }
+
+    T const&
+    at (K const& key) const
+    {
+        std::size_t const i = locate (key);
+        if (i >= mentry.size ())
+            throw std::out_of_range ("hash_table::at()const: no key");
+        return mentry[i].second;
+    }
+
+    T&
+    operator[] (K const& key)
+    {
+        std::size_t const i = locate (key);
+        if (i < mentry.size ())
+            return mentry[i].second;
+        return append (value_type (key, T ())).second;
+    }
+
+    T&
+    operator[] (K&& key)
+    {
+        std::size_t const i = locate (key);
+        if (i < mentry.size ())
+            return mentry[i].second;
+        return append (value_type (std::move (key), T ())).second;
+    }
+
+    std::pair<iterator,bool>
+    insert (value_type const& x)
+    {
+        std::size_t const i = locate (x.first);
+        if (i < mentry.size ())
+            return std::make_pair (mentry.begin () + i, false);
+        append (value_type (x));
+        return std::make_pair (mentry.end () - 1, true);
+    }
+
+    std::pair<iterator,bool>
+    insert (value_type&& x)
+    {
+        std::size_t const i = locate (x.first);
+        if (i < mentry.size ())
+            return std::make_pair (mentry.begin () + i, false);
+        append (std::move (x));
+        return std::make_pair (mentry.end () - 1, true);
+    }
+
+    size_type
+    erase (K const& key)
+    {
+        if (mslot.empty ()) {
+            std::size_t const pos = locate (key);
+            if (pos >= mentry.size ())
+                return 0;
+            if (pos + 1 != mentry.size ())
+                mentry[pos] = std::move (mentry.back ());
+            mentry.pop_back ();
+            return 1;
+        }
+        uint32_t const h = hash32 (key);
+        std::size_t const mask = mslot.size () - 1;
+        std::size_t i = h & mask;
+        for (;; i = (i + 1) & mask) {
+            if (! mslot[i].index)
+                return 0;
+            if (mslot[i].hash == h && E () (mentry[mslot[i].index - 1].first, key))
+                break;
+        }
+        std::size_t const pos = mslot[i].index - 1;
+        // backward shift deletion keeps probe sequences without tombstones.
+        for (std::size_t j = (i + 1) & mask; mslot[j].index; j = (j + 1) & mask) {
+            std::size_t const k = mslot[j].hash & mask;
+            if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+                continue;
+            mslot[i] = mslot[j];
+            i = j;
+        }
+        mslot[i].hash = 0;
+        mslot[i].index = 0;
+        std::size_t const last = mentry.size () - 1;
+        if (pos != last) {
+            std::size_t j = hash32 (mentry[last].first) & mask;
+            while (mslot[j].index != last + 1)
+                j = (j + 1) & mask;
+            mslot[j].index = pos + 1;
+            mentry[pos] = std::move (mentry[last]);
+        }
+        mentry.pop_back ();
+        return 1;
+    }
+
+private:
+    struct slot_type {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    typedef typename std::allocator_traits<A>::template rebind_alloc<slot_type>
+        slot_allocator_type;
+
+    std::vector<value_type,A> mentry;
+    std::vector<slot_type,slot_allocator_type> mslot;
+
+    static uint32_t
+    hash32 (K const& key)
+    {
+        uint64_t const h = H () (key);
+        return static_cast<uint32_t> (h ^ (h >> 32));
+    }
+
+    std::size_t
+    locate (K const& key) const
+    {
+        if (mslot.empty ()) {
+            std::size_t i = 0;
+            while (i < mentry.size () && ! E () (mentry[i].first, key))
+                ++i;
+            return i;
+        }
+        uint32_t const h = hash32 (key);
+        std::size_t const mask = mslot.size () - 1;
+        for (std::size_t i = h & mask;; i = (i + 1) & mask) {
+            if (! mslot[i].index)
+                return mentry.size ();
+            if (mslot[i].hash == h && E () (mentry[mslot[i].index - 1].first, key))
+                return mslot[i].index - 1;
+        }
+    }
+
+    value_type&
+    append (value_type&& x)
+    {
+        if (mslot.empty () && mentry.size () < SMALL_SIZE) {
+            mentry.push_back (std::move (x));
+            return mentry.back ();
+        }
+        if ((mentry.size () + 1) * 3 > mslot.size () * 2)
+            rehash (mentry.size () + 1);
+        uint32_t const h = hash32 (x.first);
+        std::size_t const mask = mslot.size () - 1;
+        std::size_t j = h & mask;
+        while (mslot[j].index)
+            j = (j + 1) & mask;
+        mentry.push_back (std::move (x));
+        mslot[j].hash = h;
+        mslot[j].index = mentry.size ();
+        return mentry.back ();
+    }
+
+    void
+    rehash (std::size_t const n)
+    {
+        std::size_t m = 8;
+        while (n * 3 > m * 2)
+            m *= 2;
+        std::vector<slot_type,slot_allocator_type> slot (m, slot_type {0, 0});
+        std::size_t const mask = m - 1;
+        // the first index hashes the entries of a small table.
+        if (mslot.empty ())
+            for (std::size_t i = 0; i < mentry.size (); ++i) {
+                uint32_t const h = hash32 (mentry[i].first);
+                std::size_t j = h & mask;
+                while (slot[j].index)
+                    j = (j + 1) & mask;
+                slot[j] = slot_type {h, static_cast<uint32_t> (i + 1)};
+            }
+        for (auto const& x : mslot) {
+            if (! x.index)
+                continue;
+            std::size_t j = x.hash & mask;
+            while (slot[j].index)
+                j = (j + 1) & mask;
+            slot[j] = x;
+        }
+        std::swap (mslot, slot);
+    }
+};
+
+}//namespace wjson
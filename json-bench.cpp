@@ -0,0 +1,91 @@
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include "value.hpp"
+#include "json.hpp"
+
+// decode time of flat JSON arrays of integers and floats, a flat
+// JSON object and an array of long strings at a quarter, a half and
+// the whole of the count, so that the time per element shows whether
+// decoding is linear.
+//
+//      json-bench [count]
+
+static std::string
+make_array (std::size_t const count)
+{
+    std::string str ("[");
+    for (std::size_t i = 0; i < count; ++i)
+        str += (i > 0 ? "," : "") + std::to_string (i);
+    return str + "]";
+}
+
+static std::string
+make_flonums (std::size_t const count)
+{
+    std::string str ("[");
+    for (std::size_t i = 0; i < count; ++i)
+        str += (i > 0 ? "," : "") + std::to_string (i) + "."
+            + std::to_string (i % 997) + "e-3";
+    return str + "]";
+}
+
+static std::string
+make_object (std::size_t const count)
+{
+    std::string str ("{");
+    for (std::size_t i = 0; i < count; ++i)
+        str += (i > 0 ? ",\"key" : "\"key") + std::to_string (i)
+            + "\":" + std::to_string (i);
+    return str + "}";
+}
+
+static std::string
+make_strings (std::size_t const count)
+{
+    std::string str ("[");
+    for (std::size_t i = 0; i < count; ++i)
+        str += (i > 0 ? ",\"" : "\"") + std::to_string (i)
+            + " the quick brown fox jumps over the lazy dog,"
+              " and the lazy dog sleeps in the sun all day long\"";
+    return str + "]";
+}
+
+static double
+msec (std::chrono::steady_clock::time_point const t0,
+    std::chrono::steady_clock::time_point const t1)
+{
+    return std::chrono::duration<double, std::milli> (t1 - t0).count ();
+}
+
+template<typename F>
+static bool
+run (char const* name, std::size_t const count, F make_input)
+{
+    bool ok = true;
+    for (std::size_t n = count / 4; n <= count; n *= 2) {
+        std::string const input = make_input (n);
+        wjson::value_type root;
+        auto t0 = std::chrono::steady_clock::now ();
+        ok = wjson::decode_json (input, root) && root.size () == n && ok;
+        auto t1 = std::chrono::steady_clock::now ();
+        std::cout << name << n << " elements " << msec (t0, t1) << " ms, "
+                  << msec (t0, t1) * 1e6 / (n > 0 ? n : 1) << " ns/element"
+                  << std::endl;
+        if (n == 0)
+            break;
+    }
+    return ok;
+}
+
+int
+main (int argc, char* argv[])
+{
+    std::size_t const count = argc > 1 ? std::atol (argv[1]) : 1000000;
+    bool const ok1 = run ("array   ", count, make_array);
+    bool const ok2 = run ("flonums ", count, make_flonums);
+    bool const ok3 = run ("object  ", count / 10, make_object);
+    bool const ok4 = run ("strings ", count / 10, make_strings);
+    return ok1 && ok2 && ok3 && ok4 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -3,6 +3,9 @@
 #include <limits>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "decode-number.hpp"
 
 bool
 almost (double x, double y)
@@ -82,6 +85,43 @@ test_fixnum_max (test::simple& ts)
     ts.ok (got.fixnum () == fixmax, "json decode " + input + " value");
 }
 
+void
+test_fixnum_overflow (test::simple& ts)
+{
+    std::string input ("[9223372036854775808,1]");
+    wjson::value_type got;
+    ts.ok (wjson::decode_json (input, got), "json decode " + input);
+    ts.ok (got.get (0).tag () == wjson::VALUE_FLONUM
+        && got.get (1).tag () == wjson::VALUE_FIXNUM,
+        "json decode " + input + " overflow to flonum");
+}
+
+void
+test_lazy_number (test::simple& ts)
+{
+    std::string input ("[12345678901234567890,-7,2.5e-3,1e999]");
+    wjson::value_type got;
+    ts.ok (wjson::decode_json (input, got, wjson::DECODE_LAZY_NUMBER),
+        "json decode lazy " + input);
+    wjson::value_type const& x = got;
+    ts.ok (x.get (0).tag () == wjson::VALUE_FIXNUM
+        && *x.get (0).literal () == "12345678901234567890", "json decode lazy big fixnum");
+    ts.ok (x.get (0).if_fixnum () == nullptr, "json decode lazy big fixnum out of range");
+    ts.ok (x.get (1).fixnum () == -7 && x.get (1) == wjson::fixnum (-7),
+        "json decode lazy fixnum");
+    ts.ok (x.get (2).tag () == wjson::VALUE_FLONUM
+        && almost (x.get (2).flonum (), 2.5e-3), "json decode lazy flonum");
+    ts.ok (x.get (3).tag () == wjson::VALUE_FLONUM && x.get (3).if_flonum () == nullptr
+        && *x.get (3).literal () == "1e999", "json decode lazy flonum out of range");
+    wjson::value_type y (x.get (0));
+    ts.ok (y == x.get (0) && y.hash () == x.get (0).hash ()
+        && y != wjson::number_literal ("12345678901234567891"),
+        "json decode lazy big fixnum equal by text");
+    got.get (1).fixnum () = 8;
+    ts.ok (x.get (1).literal () == nullptr && x.get (1).fixnum () == 8,
+        "json decode lazy fixnum written");
+}
+
 void
 test_fixnum_lowest (test::simple& ts)
 {
@@ -163,6 +203,43 @@ test_flonum_out_of_range (test::simple& ts)
     ts.ok (! wjson::decode_json (input, got), "fail json decode 1.0e2000");
 }
 
+// the fast paths give the same doubles as strtod.
+void
+test_flonum_exact (test::simple& ts)
+{
+    bool same = true;
+    uint64_t seed = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string input = std::to_string ((seed >> 11) % (i % 2 ? 10000000 : 1ULL << 53));
+        input.insert (input.size () - (seed >> 8) % input.size (), ".");
+        if (input[0] == '.')
+            input.insert (0, "0");
+        if (input.back () == '.')
+            input += "0";
+        input += "e" + std::to_string (static_cast<int> ((seed >> 3) % 80) - 40);
+        double got = 0.0;
+        double const expected = std::strtod (input.c_str (), nullptr);
+        same = same && wjson::decode_flonum (input, got)
+            && std::memcmp (&got, &expected, sizeof (double)) == 0;
+    }
+    ts.ok (same, "decode_flonum same as strtod");
+    wjson::value_type zeros;
+    ts.ok (wjson::decode_json ("[0e-30,-0e-400,0e400]", zeros)
+        && zeros.get (0).flonum () == 0.0 && ! std::signbit (zeros.get (0).flonum ())
+        && zeros.get (1).flonum () == 0.0 && std::signbit (zeros.get (1).flonum ())
+        && zeros.get (2).flonum () == 0.0 && ! std::signbit (zeros.get (2).flonum ()),
+        "json decode zeros with large exponents");
+    int64_t n = 0;
+    ts.ok (wjson::decode_fixnum ("-9223372036854775808", n)
+        && n == std::numeric_limits<int64_t>::min ()
+        && wjson::decode_fixnum ("9223372036854775807", n)
+        && n == std::numeric_limits<int64_t>::max ()
+        && ! wjson::decode_fixnum ("9223372036854775808", n)
+        && ! wjson::decode_fixnum ("100000000000000000000", n),
+        "decode_fixnum bounds");
+}
+
 void
 test_string_empty (test::simple& ts)
 {
@@ -213,6 +290,31 @@ test_string_surrogate_pair (test::simple& ts)
     ts.ok (got.string () == expected, "json decode surrogate");
 }
 
+// escapes and multibyte characters around the 16 octet runs.
+void
+test_string_long (test::simple& ts)
+{
+    bool ok = true;
+    for (std::size_t n = 0; n < 40; ++n)
+        for (std::size_t k = 0; k <= n; ++k) {
+            std::string input ("\"" + std::string (n, 'a') + "\"");
+            input.insert (k + 1, k % 2 ? "\\n" : u8"\u3044");
+            std::wstring expected (n, L'a');
+            expected.insert (k, k % 2 ? L"\n" : L"\u3044");
+            wjson::value_type got;
+            ok = ok && wjson::decode_json (input, got) && got.string () == expected;
+        }
+    ts.ok (ok, "json decode long strings");
+    bool invalid = true;
+    for (std::size_t n = 0; n < 40; ++n)
+        for (char const c : {'\n', '\x7f', '\x80'}) {
+            std::string input ("\"" + std::string (n, 'a') + c + "b\"");
+            wjson::value_type got;
+            invalid = invalid && ! wjson::decode_json (input, got);
+        }
+    ts.ok (invalid, "json decode invalid octets in long strings");
+}
+
 void
 test_array_empty (test::simple& ts)
 {
@@ -258,6 +360,37 @@ test_array_nest (test::simple& ts)
     ts.ok (got[2][1].string () == L"c", "json decode array nest [2][1]");
 }
 
+void
+test_array_packed (test::simple& ts)
+{
+    std::string input (R"q([[1,2,3],[0.5,-1.5],[true,false],[1,2.0],[]])q");
+    wjson::value_type got;
+    ts.ok (wjson::decode_json (input, got, wjson::DECODE_PACK_ARRAY),
+        "json decode array packed");
+    ts.ok (got.packed () == wjson::PACK_NONE, "json decode array packed outer");
+    wjson::value_type const& x = got;
+    ts.ok (x.get (0).packed () == wjson::PACK_FIXNUM
+        && x.get (0).fixnums ()[2] == 3, "json decode array packed fixnums");
+    ts.ok (x.get (1).packed () == wjson::PACK_FLONUM
+        && almost (x.get (1).flonums ()[1], -1.5), "json decode array packed flonums");
+    ts.ok (x.get (2).packed () == wjson::PACK_BOOLEAN
+        && ! x.get (2).booleans ()[1], "json decode array packed booleans");
+    ts.ok (x.get (3).packed () == wjson::PACK_NONE
+        && x.get (4).packed () == wjson::PACK_NONE, "json decode array packed mixed");
+}
+
+void
+test_table_intern (test::simple& ts)
+{
+    std::string input (R"q([{"id":1,"name":"a"},{"id":2,"name":"b"}])q");
+    wjson::document_type doc;
+    ts.ok (wjson::decode_json (input, doc), "json decode table intern");
+    wjson::value_type const& x = doc.root ();
+    ts.ok (doc.pool ().size () == 2
+        && x.get (0).table ().begin ()->first.interned_with (
+            x.get (1).table ().begin ()->first), "json decode table intern keys");
+}
+
 void
 test_table_empty (test::simple& ts)
 {
@@ -355,9 +488,77 @@ R"q({
         "json decode [fruit][1][variety][0][name]");
 }
 
+void
+test_delimiter (test::simple& ts)
+{
+    wjson::value_type got;
+    ts.ok (wjson::decode_json (" \t[ 1 ,\"a\"\n,true ]\r\n", got) && got.size () == 3,
+        "json decode white space between tokens");
+    bool invalid = true;
+    for (char const* input : {"[1x]", "[1.5.3]", "[true1]", "[\"a\"x]",
+            "{\"a\"b:1}", "[1]x", "[\f1]", "[-]", "[1 2]"})
+        invalid = invalid && ! wjson::decode_json (input, got);
+    ts.ok (invalid, "json decode garbage after tokens");
+}
+
+// writes the events in a line.
+struct trace_handler : wjson::json_handler_type {
+    std::wstring got;
+    bool null () { got += L"null "; return true; }
+    bool boolean (bool const x) { got += x ? L"true " : L"false "; return true; }
+    bool fixnum (int64_t const x) { got += std::to_wstring (x) + L" "; return true; }
+    bool flonum (double const x) { got += std::to_wstring (x) + L" "; return true; }
+    bool string (wjson::string_type& x)
+    {
+        got += L"'" + std::wstring (x.cbegin (), x.cend ()) + L"' ";
+        return true;
+    }
+    bool begin_array () { got += L"[ "; return true; }
+    bool end_array () { got += L"] "; return true; }
+    bool begin_table () { got += L"{ "; return true; }
+    bool key (wjson::string_type& x)
+    {
+        got += std::wstring (x.cbegin (), x.cend ()) + L": ";
+        return true;
+    }
+    bool end_table () { got += L"} "; return true; }
+};
+
+void
+test_handler (test::simple& ts)
+{
+    std::string input (R"q({"a":[1,2.5,"x",{}],"b":{"c":null,"d":true},"e":[]})q");
+    trace_handler h;
+    ts.ok (wjson::decode_json (input, h), "json decode handler");
+    ts.ok (h.got == L"{ a: [ 1 2.500000 'x' { } ] b: { c: null d: true } e: [ ] } ",
+        "json decode handler events");
+    trace_handler lazy;
+    ts.ok (wjson::decode_json ("[9223372036854775808,7]", lazy,
+        wjson::DECODE_LAZY_NUMBER), "json decode handler literal");
+    ts.ok (lazy.got == L"[ 9223372036854775808.000000 7 ] ",
+        "json decode handler literal converted");
+}
+
+// counts integers and stops at the third.
+struct limit_handler : wjson::json_handler_type {
+    int count = 0;
+    bool fixnum (int64_t const) { return ++count < 3; }
+};
+
+void
+test_handler_stop (test::simple& ts)
+{
+    limit_handler h;
+    ts.ok (! wjson::decode_json ("[1,2,3,4,5]", h), "json decode handler stop");
+    ts.ok (h.count == 3, "json decode handler stop count");
+    limit_handler invalid;
+    ts.ok (! wjson::decode_json ("[1,}", invalid) && invalid.count == 1,
+        "json decode handler invalid");
+}
+
 int main ()
 {
-    test::simple ts (99);
+    test::simple ts (131);
 
     test_null (ts);
     test_true (ts);
@@ -366,6 +567,8 @@ int main ()
     test_fixnum_one (ts);
     test_fixnum_negative_one (ts);
     test_fixnum_max (ts);
+    test_fixnum_overflow (ts);
+    test_lazy_number (ts);
     test_fixnum_lowest (ts);
     test_flonum_zero (ts);
     test_flonum_one (ts);
@@ -374,17 +577,24 @@ int main ()
     test_flonum_g (ts);
     test_flonum_e30 (ts);
     test_flonum_out_of_range (ts);
+    test_flonum_exact (ts);
     test_string_empty (ts);
     test_string_ascii (ts);
     test_string_mbyte (ts);
     test_string_surrogate_pair (ts);
+    test_string_long (ts);
     test_array_empty (ts);
     test_array_flat (ts);
     test_array_nest (ts);
+    test_array_packed (ts);
+    test_table_intern (ts);
     test_table_empty (ts);
     test_table_flat (ts);
     test_table_nest (ts);
     test_table_fluit (ts);
+    test_delimiter (ts);
+    test_handler (ts);
+    test_handler_stop (ts);
 
     return ts.done_testing ();
 }
@@ -3,7 +3,13 @@
 #include <map>
 #include <deque>
 #include <utility>
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "json.hpp"
+#include "json-index.hpp"
+#include "encode-utf8.hpp"
+#include "decode-number.hpp"
 
 namespace wjson {
 
@@ -20,24 +26,186 @@ enum {
     TOKEN_ENDMARK,
 };
 
+// kinds of TOKEN_SCALAR.
+enum {
+    SCALAR_NULL,
+    SCALAR_TRUE,
+    SCALAR_FALSE,
+    SCALAR_FIXNUM,
+    SCALAR_FLONUM,
+    SCALAR_LITERAL,
+};
+
 class json_decoder_type {
 public:
-    json_decoder_type (std::string const& str);
-    bool decode (value_type& root);
+    json_decoder_type (std::string const& str, int const flags);
+    bool decode (json_handler_type& handler);
 private:
+    int const flags;
     std::string const& string;
     std::string::const_iterator iter;
+    json_index_type index;
+    int token_scalar;
+    int64_t token_fixnum;
+    double token_flonum;
+    std::string token_literal;
+    string_type token_text;
+    string_type pending;
 
-    int next_token (value_type& value);
-    int scan_string (value_type& value);
-    int scan_number (value_type& value);
+    bool shift (json_handler_type& handler, int const token_type);
+    int next_token ();
+    int scan_string ();
+    int scan_number ();
 };
 
+// builds the tree of decode_json from the events.
+class json_builder_type : public json_handler_type {
+public:
+    explicit json_builder_type (int const flags) : flags (flags) {}
+    value_type& root () { return value; }
+    bool null () { return put (::wjson::null ()); }
+    bool boolean (bool const x) { return put (::wjson::boolean (x)); }
+    bool fixnum (int64_t const x) { return put (::wjson::fixnum (x)); }
+    bool flonum (double const x) { return put (::wjson::flonum (x)); }
+    bool literal (std::string const& x);
+    bool string (string_type& x) { return put (::wjson::string (std::move (x))); }
+    bool begin_array ();
+    bool end_array ();
+    bool begin_table ();
+    bool key (string_type& x);
+    bool end_table ();
+private:
+    int const flags;
+    value_type value;
+    std::vector<value_type> stack;
+    std::vector<string_type> keys;
+
+    bool put (value_type&& x);
+};
+
+json_handler_type::~json_handler_type () {}
+bool json_handler_type::null () { return true; }
+bool json_handler_type::boolean (bool const) { return true; }
+bool json_handler_type::fixnum (int64_t const) { return true; }
+bool json_handler_type::flonum (double const) { return true; }
+bool json_handler_type::string (string_type&) { return true; }
+bool json_handler_type::begin_array () { return true; }
+bool json_handler_type::end_array () { return true; }
+bool json_handler_type::begin_table () { return true; }
+bool json_handler_type::key (string_type&) { return true; }
+bool json_handler_type::end_table () { return true; }
+
+// an integer that does not fit becomes a flonum, as without
+// DECODE_LAZY_NUMBER.
+bool
+json_handler_type::literal (std::string const& x)
+{
+    int64_t n;
+    double d;
+    if (x.find_first_of (".eE") == std::string::npos && decode_fixnum (x, n))
+        return fixnum (n);
+    return decode_flonum (x, d) && flonum (d);
+}
+
+bool
+decode_json (std::string const& str, json_handler_type& handler, int const flags)
+{
+    json_decoder_type decoder (str, flags);
+    return decoder.decode (handler);
+}
+
+bool
+decode_json (std::string const& str, value_type& root, int const flags)
+{
+    intern_pool_type pool;
+    intern_scope keys (current_pool () ? *current_pool () : pool);
+    json_builder_type builder (flags);
+    json_decoder_type decoder (str, flags);
+    if (! decoder.decode (builder))
+        return false;
+    std::swap (root, builder.root ());
+    return true;
+}
+
+bool
+decode_json (std::string const& str, document_type& doc, int const flags)
+{
+    arena_scope scope (doc.arena ());
+    intern_scope keys (doc.pool ());
+    return decode_json (str, doc.root (), flags);
+}
+
+bool
+json_builder_type::literal (std::string const& x)
+{
+    return put (::wjson::number_literal (x));
+}
+
+bool
+json_builder_type::begin_array ()
+{
+    stack.push_back (::wjson::array ());
+    return true;
+}
+
+bool
+json_builder_type::end_array ()
+{
+    value_type x (std::move (stack.back ()));
+    stack.pop_back ();
+    if (flags & DECODE_PACK_ARRAY)
+        x.pack ();
+    return put (std::move (x));
+}
+
+bool
+json_builder_type::begin_table ()
+{
+    stack.push_back (::wjson::table ());
+    keys.emplace_back ();
+    return true;
+}
+
+bool
+json_builder_type::key (string_type& x)
+{
+    std::swap (keys.back (), x);
+    return true;
+}
+
 bool
-decode_json (std::string const& str, value_type& root)
+json_builder_type::end_table ()
 {
-    json_decoder_type decoder (str);
-    return decoder.decode (root);
+    value_type x (std::move (stack.back ()));
+    stack.pop_back ();
+    keys.pop_back ();
+    return put (std::move (x));
+}
+
+// containers move into their parents as they end, so that
+// the tree is never copied.
+bool
+json_builder_type::put (value_type&& x)
+{
+    if (stack.empty ())
+        value = std::move (x);
+    else if (stack.back ().tag () == VALUE_ARRAY)
+        stack.back ().push_back (std::move (x));
+    else
+        stack.back ().set (std::move (keys.back ()), std::move (x));
+    return true;
+}
+
+static inline bool
+delimiter (char const c)
+{
+    switch (c) {
+    case ' ': case '\t': case '\n': case '\r':
+    case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+        return true;
+    default:
+        return false;
+    }
 }
 
 static inline int
@@ -63,13 +231,47 @@ hex (uint32_t const octet)
           : 0;
 }
 
-json_decoder_type::json_decoder_type (std::string const& str)
-    : string (str), iter (str.cbegin ())
+// skips a run of printable ASCII but quotes, backslashes and DEL,
+// which a string copies as it is.
+static std::string::const_iterator
+skip_plain (std::string::const_iterator s, std::string::const_iterator const e)
+{
+#if defined (__SSE2__)
+    // octets from 0x80 are negative, and less than ' ' as signed.
+    __m128i const space = _mm_set1_epi8 (' ');
+    __m128i const quote = _mm_set1_epi8 ('"');
+    __m128i const backslash = _mm_set1_epi8 ('\\');
+    __m128i const del = _mm_set1_epi8 (0x7f);
+    for (; e - s >= 16; s += 16) {
+        __m128i const x = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (&*s));
+        __m128i const stop = _mm_or_si128 (_mm_cmplt_epi8 (x, space),
+            _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (x, quote),
+                _mm_cmpeq_epi8 (x, backslash)), _mm_cmpeq_epi8 (x, del)));
+        int const mask = _mm_movemask_epi8 (stop);
+        if (mask)
+            return s + __builtin_ctz (mask);
+    }
+#endif
+    for (; s < e; ++s) {
+        uint32_t const octet = ord (*s);
+        if (octet < ' ' || 0x7f <= octet || octet == '"' || octet == '\\')
+            break;
+    }
+    return s;
+}
+
+json_decoder_type::json_decoder_type (std::string const& str, int const flags)
+    : flags (flags), string (str), iter (str.cbegin ()), index (str),
+      token_scalar (SCALAR_NULL),
+      token_fixnum (0), token_flonum (0.0)
 {
 }
 
+// tokens start at the positions of the index, and events go to
+// the handler as tokens shift, except that a string
+// waits for the next token to tell a key from a value.
 bool
-json_decoder_type::decode (value_type& root)
+json_decoder_type::decode (json_handler_type& handler)
 {
     enum { NCHECK = 83, ACCEPT = 255 };
     static const int BASE[23] = {
@@ -97,10 +299,7 @@ json_decoder_type::decode (value_type& root)
     };
     iter = string.cbegin ();
     std::deque<int> sstack {1};
-    std::deque<value_type> dstack;
-    dstack.emplace_back (); // centinel
-    value_type token_value;
-    int token_type = next_token (token_value);
+    int token_type = next_token ();
     for (;;) {
         int prev_state = sstack.back ();        
         int j = BASE[prev_state] + token_type;
@@ -112,51 +311,20 @@ json_decoder_type::decode (value_type& root)
             break;
         else if (ctrl < 128) {  // shift
             sstack.push_back (ctrl);
-            dstack.push_back (token_value);
-            token_type = next_token (token_value);
+            if (! shift (handler, token_type))
+                return false;
+            token_type = next_token ();
         }
         else if (ctrl == ACCEPT) {
-            std::swap (root, dstack.back ());
             return true;
         }
         else {    // reduce
             int prod = 256 - ctrl - 2;
             int nrhs = NRHS[prod];
-            std::deque<value_type>::iterator v = dstack.end () - nrhs - 1;
-            value_type value;
-            switch (prod) {
-            case  0: // start: value
-            case  1: // value: SCALAR
-            case  2: // value: STRING
-                std::swap (value, v[1]);
-                break;
-            case  3: // value: "[" array "]"
-            case  4: // value: "{" table "}"
-                std::swap (value, v[2]);
-                break;
-            case  5: // value: "[" "]"
-                value = ::wjson::array ();
-                break;
-            case  6: // value: "{" "}"
-                value = ::wjson::table ();
-                break;
-            case  7: // array: array "," value
-                value = std::move (v[1].push_back (std::move (v[3])));
-                break;
-            case  8: // array: value
-                value = ::wjson::array ().push_back (std::move (v[1]));
-                break;
-            case  9: // table: table "," STRING ":" value
-                value = std::move (v[1].set (v[3], std::move (v[5])));
-                break;
-            case 10: // table: STRING ":" value
-                value = ::wjson::table ().set (v[1], std::move (v[3]));
-                break;
-            }
+            if (prod == 2 && ! handler.string (pending)) // value: STRING
+                return false;
             for (int i = 0; i < nrhs; ++i)
                 sstack.pop_back ();
-            for (int i = 0; i < nrhs; ++i)
-                dstack.pop_back ();
             int gprev_state = sstack.back ();
             int g = BASE[gprev_state] + GOTO[prod];
             int gnext_state = 0;
@@ -165,14 +333,38 @@ json_decoder_type::decode (value_type& root)
             if (! gnext_state)
                 std::logic_error ("json_decoder::decode: grammar table error");
             sstack.push_back (gnext_state);
-            dstack.push_back (value);
         }
     }
     return false;
 }
 
+bool
+json_decoder_type::shift (json_handler_type& handler, int const token_type)
+{
+    switch (token_type) {
+    case TOKEN_SCALAR:
+        switch (token_scalar) {
+        case SCALAR_NULL: return handler.null ();
+        case SCALAR_TRUE: return handler.boolean (true);
+        case SCALAR_FALSE: return handler.boolean (false);
+        case SCALAR_FIXNUM: return handler.fixnum (token_fixnum);
+        case SCALAR_FLONUM: return handler.flonum (token_flonum);
+        default: return handler.literal (token_literal);
+        }
+    case TOKEN_STRING:
+        std::swap (pending, token_text);
+        return true;
+    case TOKEN_COLON: return handler.key (pending);
+    case TOKEN_LBRACKET: return handler.begin_array ();
+    case TOKEN_RBRACKET: return handler.end_array ();
+    case TOKEN_LBRACE: return handler.begin_table ();
+    case TOKEN_RBRACE: return handler.end_table ();
+    default: return true;
+    }
+}
+
 int
-json_decoder_type::next_token (value_type& value)
+json_decoder_type::next_token ()
 {
     enum { NSHIFT = 21, SNUMBER = 10 };
     static const uint32_t CCLASS[16] = {
@@ -191,7 +383,9 @@ json_decoder_type::next_token (value_type& value)
     };
     static const uint32_t MATCH = 12U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    std::string literal;
+    std::size_t pos;
+    iter = index.next (pos) ? string.cbegin () + pos : string.cend ();
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
@@ -207,18 +401,18 @@ json_decoder_type::next_token (value_type& value)
             kind = (SHIFT[m] >> 8) & 0xff;
             switch (kind) {
             case TOKEN_STRING:
-                kind = scan_string (value);
+                kind = scan_string ();
                 break;
             case SNUMBER:
-                kind = scan_number (value);
+                kind = scan_number ();
                 break;
             case TOKEN_SCALAR:
-                if (literal == L"true")
-                    value = ::wjson::boolean (true);
-                else if (literal == L"false")
-                    value = ::wjson::boolean (false);
-                else if (literal == L"null")
-                    value = ::wjson::null ();
+                if (literal == "true")
+                    token_scalar = SCALAR_TRUE;
+                else if (literal == "false")
+                    token_scalar = SCALAR_FALSE;
+                else if (literal == "null")
+                    token_scalar = SCALAR_NULL;
                 else
                     return false;
                 iter = s;
@@ -243,11 +437,14 @@ json_decoder_type::next_token (value_type& value)
         kind = TOKEN_ENDMARK;
         iter = s;
     }
+    // the index does not list the octet after a number or a name.
+    if (kind == TOKEN_SCALAR && iter != e && ! delimiter (*iter))
+        kind = TOKEN_INVALID;
     return kind;
 }
 
 int
-json_decoder_type::scan_string (value_type& value)
+json_decoder_type::scan_string ()
 {
     enum { NSHIFT = 37 };
     static const uint32_t U16SPHFROM = 0xd800L;
@@ -281,13 +478,23 @@ json_decoder_type::scan_string (value_type& value)
     };
     static const uint32_t MATCH = 10U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    string_type& literal = token_text;
+    literal.clear ();
     uint32_t uc = 0;
     uint32_t u16hi = 0;
     int mbyte = 1;
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
+        // states 2 and 6 are in the body of the string.
+        if (next_state == 2 || next_state == 6) {
+            std::string::const_iterator const t = skip_plain (s, e);
+            if (t != s) {
+                literal.append (s, t);
+                s = t;
+                next_state = 6;
+            }
+        }
         uint32_t octet = s == e ? '\0' : ord (*s);
         int const cls = s == e ? 0 : lookup_cls (CCLASS, 256U, octet);
         int const prev_state = next_state;
@@ -298,7 +505,6 @@ json_decoder_type::scan_string (value_type& value)
             next_state = (SHIFT[j] >> 8) & 0xff;
         if (0 < m && m < NSHIFT && (SHIFT[m] & 0xff) == prev_state) {
             kind = (SHIFT[m] >> 8) & 0xff;
-            value = ::wjson::string (literal);
             iter = s;
         }
         if (! next_state)
@@ -320,7 +526,7 @@ json_decoder_type::scan_string (value_type& value)
                 return false;
             if (U16SPHFROM <= uc && uc <= U16SPLLAST)
                 return false;
-            literal.push_back (uc);
+            append_code (literal, uc);
             uc = 0;
             break;
         case 3:
@@ -351,7 +557,7 @@ json_decoder_type::scan_string (value_type& value)
                 next_state = 12;
             }
             else {
-                literal.push_back (uc);
+                append_code (literal, uc);
             }
             uc = 0;
             break;
@@ -359,7 +565,7 @@ json_decoder_type::scan_string (value_type& value)
             uc = (uc << 4) + hex (octet);
             if (uc < U16SPLFROM || U16SPLLAST < uc)
                 return false;
-            literal.push_back ((u16hi << 10) + uc - U16SPOFFSET);
+            append_code (literal, (u16hi << 10) + uc - U16SPOFFSET);
             u16hi = 0;
             uc = 0;
             break;
@@ -371,7 +577,7 @@ json_decoder_type::scan_string (value_type& value)
 }
 
 int
-json_decoder_type::scan_number (value_type& value)
+json_decoder_type::scan_number ()
 {
     enum { NSHIFT = 35 };
     static const uint32_t CCLASS[16] = {
@@ -390,10 +596,11 @@ json_decoder_type::scan_number (value_type& value)
             0,     0,     0,     0, 0x209 
     };
     static const uint32_t MATCH = 7U;
-    int kind = TOKEN_INVALID;
-    std::wstring literal;
+    bool matched = false;
+    bool isfixnum = false;
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
+    std::string::const_iterator last = s;
     for (int next_state = 1; s <= e; ++s) {
         uint32_t octet = s == e ? '\0' : ord (*s);
         int const cls = s == e ? 0 : lookup_cls (CCLASS, 128U, octet);
@@ -403,32 +610,31 @@ json_decoder_type::scan_number (value_type& value)
         int const m = BASE[prev_state] + MATCH;
         if (0 < j && j < NSHIFT && (SHIFT[j] & 0xff) == prev_state)
             next_state = (SHIFT[j] >> 8) & 0xff;
-        if (next_state && s < e)
-            literal.push_back (octet);
         if (0 < m && m < NSHIFT && (SHIFT[m] & 0xff) == prev_state) {
-            int isfixnum = 1 == ((SHIFT[m] >> 8) & 0xff);
-            if (isfixnum)
-                try {
-                    value = ::wjson::fixnum (std::stoll (literal));
-                }
-                catch (std::out_of_range) {
-                    isfixnum = false;
-                }
-            if (! isfixnum)
-                try {
-                    value = ::wjson::flonum (std::stod (literal));
-                }
-                catch (std::out_of_range) {
-                    value = ::wjson::null ();
-                    return TOKEN_INVALID;
-                }
-            kind = TOKEN_SCALAR;
-            iter = s;
+            matched = true;
+            isfixnum = 1 == ((SHIFT[m] >> 8) & 0xff);
+            last = s;
         }
         if (! next_state)
             break;
     }
-    return kind;
+    if (! matched)
+        return TOKEN_INVALID;
+    // converts the matched octets in place.
+    char const* const first = string.data () + (iter - string.cbegin ());
+    char const* const limit = first + (last - iter);
+    if (flags & DECODE_LAZY_NUMBER) {
+        token_scalar = SCALAR_LITERAL;
+        token_literal.assign (first, limit);
+    }
+    else if (isfixnum && decode_fixnum (first, limit, token_fixnum))
+        token_scalar = SCALAR_FIXNUM;
+    else if (decode_flonum (first, limit, token_flonum))
+        token_scalar = SCALAR_FLONUM;
+    else
+        return TOKEN_INVALID;
+    iter = last;
+    return TOKEN_SCALAR;
 }
 
 }//namespace wjson
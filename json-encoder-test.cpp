@@ -139,6 +139,17 @@ test_flonum_lowest (test::simple& ts)
     ts.ok (got.str () == expected, "json encode " + expected);
 }
 
+void
+test_number_literal (test::simple& ts)
+{
+    wjson::value_type input = wjson::array ();
+    input.push_back (wjson::number_literal ("12345678901234567890"));
+    input.push_back (wjson::number_literal ("1.50E+3"));
+    std::ostringstream got;
+    wjson::encode_json (got, input);
+    ts.ok (got.str () == "[12345678901234567890,1.50E+3]", "json encode number literal");
+}
+
 void
 test_datetime (test::simple& ts)
 {
@@ -160,7 +171,7 @@ test_string_empty (test::simple& ts)
 void
 test_string_ascii (test::simple& ts)
 {
-    std::wstring ascii;
+    wjson::string_type ascii;
     for (int c = 0; c < 128; ++c)
         ascii.push_back (c);
     wjson::value_type input = wjson::string (ascii);
@@ -393,7 +404,7 @@ R"q({
 int
 main ()
 {
-    test::simple ts (26);
+    test::simple ts (27);
 
     test_null (ts);
 
@@ -411,6 +422,7 @@ main ()
     test_flonum_negative_one (ts);
     test_flonum_max (ts);
     test_flonum_lowest (ts);
+    test_number_literal (ts);
 
     test_datetime (ts);
 
@@ -9,7 +9,9 @@
 namespace wjson {
 
 static void encode_flonum (std::ostream& out, double const x);
-static void encode_string (std::ostream& out, std::wstring const& str);
+static void encode_string (std::ostream& out, string_type const& str);
+static void encode_element (std::ostream& out, value_type const& value,
+    std::size_t const i);
 
 std::string
 encode_json (value_type const& value, int const padding, int const margin)
@@ -36,20 +38,32 @@ encode_json (std::ostream& out, value_type const& value,
         else
             out << "false";
         break;
-    case VALUE_FIXNUM: out << value.fixnum (); break;
-    case VALUE_FLONUM: encode_flonum (out, value.flonum ()); break;
-    case VALUE_DATETIME: encode_string (out, value.datetime ()); break;
+    case VALUE_FIXNUM:
+    case VALUE_FLONUM:
+        if (value.literal () != nullptr)
+            out << *value.literal ();
+        else if (value.tag () == VALUE_FIXNUM)
+            out << value.fixnum ();
+        else
+            encode_flonum (out, value.flonum ());
+        break;
+    case VALUE_DATETIME:
+        out << "\"" << encode_datetime (value.datetime ()) << "\"";
+        break;
     case VALUE_STRING: encode_string (out, value.string ()); break;
     case VALUE_ARRAY:
         if (value.size () == 0)
             out << "[]";
         else {
             out << "[" << endl;
-            for (auto& x : value.array ()) {
-                if (count++ > 0)
+            for (std::size_t i = 0; i < value.size (); ++i) {
+                if (i > 0)
                     out << "," << endl;
                 out << nest;
-                encode_json (out, x, padding, margin + padding);
+                if (value.packed () == PACK_NONE)
+                    encode_json (out, value.array ()[i], padding, margin + padding);
+                else
+                    encode_element (out, value, i);
             }
             out << endl << indent << "]";
         }
@@ -59,13 +73,13 @@ encode_json (std::ostream& out, value_type const& value,
             out << "{}";
         else {
             out << "{" << endl;
-            for (auto& x : value.table ()) {
+            for (auto x : sorted_entries (value.table ())) {
                 if (count++ > 0)
                     out << "," << endl;
                 out << nest;
-                encode_string (out, x.first);
+                encode_string (out, x->first);
                 out << ":" << space;
-                encode_json (out, x.second, padding, margin + padding);
+                encode_json (out, x->second, padding, margin + padding);
             }
             out << endl << indent << "}";
         }
@@ -73,6 +87,20 @@ encode_json (std::ostream& out, value_type const& value,
     }
 }
 
+// an element of packed array.
+static void
+encode_element (std::ostream& out, value_type const& value, std::size_t const i)
+{
+    switch (value.packed ()) {
+    case PACK_BOOLEAN:
+        out << (value.booleans ()[i] ? "true" : "false");
+        break;
+    case PACK_FIXNUM: out << value.fixnums ()[i]; break;
+    case PACK_FLONUM: encode_flonum (out, value.flonums ()[i]); break;
+    default: break;
+    }
+}
+
 static void
 encode_flonum (std::ostream& out, double const x)
 {
@@ -85,10 +113,10 @@ encode_flonum (std::ostream& out, double const x)
 }
 
 static void
-encode_string (std::ostream& out, std::wstring const& str)
+encode_string (std::ostream& out, string_type const& str)
 {
     out.put ('"');
-    for (std::wstring::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
+    for (string_type::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
         uint32_t const uc = static_cast<uint32_t> (*s);
         if (uc < 0x80) {
             switch (uc) {
@@ -115,7 +143,7 @@ encode_string (std::ostream& out, std::wstring const& str)
             }
         }
         else {
-            encode_utf8 (out, uc);
+            encode_utf8 (out, *s);
         }
     }
     out.put ('"');
@@ -0,0 +1,109 @@
+#include "json-index.hpp"
+#include "taptests.hpp"
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+static std::vector<std::size_t>
+positions (std::string const& str)
+{
+    std::vector<std::size_t> got;
+    wjson::json_index_type index (str);
+    std::size_t pos;
+    while (index.next (pos))
+        got.push_back (pos);
+    return got;
+}
+
+// the same positions found octet by octet.
+static std::vector<std::size_t>
+expected (std::string const& str)
+{
+    std::vector<std::size_t> want;
+    bool inside = false;
+    bool escaped = false;
+    bool follow = true;
+    for (std::size_t i = 0; i < str.size (); ++i) {
+        char const c = str[i];
+        bool const quote = c == '"' && ! escaped;
+        if (quote)
+            inside = ! inside;
+        bool const structural = c != '\0' && std::strchr ("{}[]:,", c) != nullptr
+            && ! inside;
+        bool const space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        bool const delimiter = structural || space || quote;
+        if (structural || (quote && inside) || (! delimiter && ! inside && follow))
+            want.push_back (i);
+        follow = delimiter;
+        escaped = c == '\\' && ! escaped;
+    }
+    return want;
+}
+
+void
+test_tokens (test::simple& ts)
+{
+    std::string const input (R"q( {"a": [1, true,"x y"],"b":-2.5e3 } )q");
+    std::vector<std::size_t> const want {
+        1, 2, 5, 7, 8, 9, 11, 15, 16, 21, 22, 23, 26, 27, 34};
+    ts.ok (positions (input) == want, "json_index tokens");
+    ts.ok (positions ("").empty () && positions ("  \n\t").empty (),
+        "json_index empty");
+}
+
+void
+test_escape (test::simple& ts)
+{
+    std::string const input (R"q(["a\"b","c\\",1,"\\\"]"])q");
+    std::vector<std::size_t> const want {0, 1, 7, 8, 13, 14, 15, 16, 23};
+    ts.ok (positions (input) == want, "json_index escaped quotes");
+}
+
+void
+test_blocks (test::simple& ts)
+{
+    bool ok = true;
+    for (std::size_t n = 50; n < 80; ++n) {
+        std::string const input = "[" + std::string (n, ' ')
+            + R"q("ab\\\"c", "\\", x1])q";
+        ok = ok && positions (input) == expected (input);
+    }
+    ts.ok (ok, "json_index strings and escapes across blocks");
+}
+
+// inputs from a small alphabet, generated by a linear congruential
+// generator, so that they are the same on each run.
+void
+test_random (test::simple& ts)
+{
+    static char const ALPHABET[] = "\"\"\\\\[]{}:,  \na1t\x80";
+    uint32_t seed = 12345;
+    auto random = [&seed](uint32_t const n) {
+        seed = seed * 1103515245U + 12345U;
+        return (seed >> 16) % n;
+    };
+    bool ok = true;
+    for (int k = 0; k < 2000 && ok; ++k) {
+        std::string input (random (300), ' ');
+        for (auto& c : input)
+            c = ALPHABET[random (sizeof (ALPHABET) - 1)];
+        ok = positions (input) == expected (input);
+    }
+    ts.ok (ok, "json_index random inputs");
+    std::string large (100000, ' ');
+    for (auto& c : large)
+        c = ALPHABET[random (sizeof (ALPHABET) - 1)];
+    ts.ok (positions (large) == expected (large), "json_index chunks");
+}
+
+int
+main ()
+{
+    test::simple ts (6);
+    test_tokens (ts);
+    test_escape (ts);
+    test_blocks (ts);
+    test_random (ts);
+    return ts.done_testing ();
+}
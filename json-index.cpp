@@ -0,0 +1,143 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "json-index.hpp"
+
+namespace wjson {
+
+// bit i of a mask tells octet i of a block.
+struct block_masks_type {
+    uint64_t mquote;
+    uint64_t mbackslash;
+    uint64_t mstructural;
+    uint64_t mspace;
+};
+
+#if defined (__SSE2__)
+static inline uint64_t
+match (__m128i const x, char const c, int const shift)
+{
+    return static_cast<uint64_t> (static_cast<uint32_t> (
+        _mm_movemask_epi8 (_mm_cmpeq_epi8 (x, _mm_set1_epi8 (c))))) << shift;
+}
+
+// '[' and '{', and ']' and '}', differ in the bit 0x20 only.
+static void
+classify (char const* p, block_masks_type& m)
+{
+    m = block_masks_type {0, 0, 0, 0};
+    __m128i const case_bit = _mm_set1_epi8 (0x20);
+    for (int k = 0; k < 64; k += 16) {
+        __m128i const x = _mm_loadu_si128 (reinterpret_cast<__m128i const*> (p + k));
+        __m128i const folded = _mm_or_si128 (x, case_bit);
+        m.mquote |= match (x, '"', k);
+        m.mbackslash |= match (x, '\\', k);
+        m.mstructural |= match (folded, '{', k) | match (folded, '}', k)
+            | match (x, ':', k) | match (x, ',', k);
+        m.mspace |= match (x, ' ', k) | match (x, '\t', k)
+            | match (x, '\n', k) | match (x, '\r', k);
+    }
+}
+#else
+static void
+classify (char const* p, block_masks_type& m)
+{
+    m = block_masks_type {0, 0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+        uint64_t const bit = static_cast<uint64_t> (1) << i;
+        switch (p[i]) {
+        case '"': m.mquote |= bit; break;
+        case '\\': m.mbackslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            m.mstructural |= bit;
+            break;
+        case ' ': case '\t': case '\n': case '\r': m.mspace |= bit; break;
+        default: break;
+        }
+    }
+}
+#endif
+
+// bit i is the parity of the bits 0 to i.
+static inline uint64_t
+prefix_xor (uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+json_index_type::json_index_type (std::string const& str)
+    : mstring (str), mblock (0), mpositions (), mcursor (0),
+      minside (0), mescaped (0), mfollow (1)
+{
+}
+
+bool
+json_index_type::next (std::size_t& pos)
+{
+    while (mcursor == mpositions.size ()) {
+        if (mblock >= mstring.size ())
+            return false;
+        fill ();
+    }
+    pos = mpositions[mcursor++];
+    return true;
+}
+
+// the last block is padded with spaces.
+void
+json_index_type::fill ()
+{
+    mpositions.clear ();
+    mcursor = 0;
+    std::size_t const size = mstring.size ();
+    std::size_t const last = std::min (size, mblock + CHUNK_SIZE);
+    for (; mblock < last; mblock += BLOCK_SIZE) {
+        char pad[BLOCK_SIZE];
+        char const* p = mstring.data () + mblock;
+        if (size - mblock < BLOCK_SIZE) {
+            std::memset (pad, ' ', BLOCK_SIZE);
+            std::memcpy (pad, p, size - mblock);
+            p = pad;
+        }
+        block_masks_type m;
+        classify (p, m);
+        // a backslash escapes the next octet unless it is escaped itself.
+        // backslashes are rare, so that they are walked one by one.
+        uint64_t escaped = mescaped;
+        mescaped = 0;
+        for (uint64_t b = m.mbackslash; b != 0; b &= b - 1) {
+            int const i = __builtin_ctzll (b);
+            if (escaped & (static_cast<uint64_t> (1) << i))
+                continue;
+            if (i == BLOCK_SIZE - 1)
+                mescaped = 1;
+            else
+                escaped |= static_cast<uint64_t> (2) << i;
+        }
+        uint64_t const quote = m.mquote & ~escaped;
+        // from an opening quote to the octet before its closing quote.
+        uint64_t const inside = prefix_xor (quote) ^ minside;
+        minside = 0 - (inside >> (BLOCK_SIZE - 1));
+        uint64_t const structural = m.mstructural & ~inside;
+        uint64_t const delimiter = structural | m.mspace | quote;
+        uint64_t const start = ((delimiter << 1) | mfollow)
+            & ~(delimiter | inside);
+        mfollow = delimiter >> (BLOCK_SIZE - 1);
+        for (uint64_t bits = structural | (quote & inside) | start; bits != 0;
+                bits &= bits - 1)
+            mpositions.push_back (mblock + __builtin_ctzll (bits));
+    }
+}
+
+}//namespace wjson
@@ -0,0 +1,48 @@
+#pragma once
+
+/* json_index_type is the first stage of the JSON decoder.
+ *
+ * it classifies the input 64 octets at a time, with SSE2 where the target
+ * has it, and lists the positions where tokens start: structural
+ * characters, opening quotes of strings, and the first octets of numbers
+ * and names. quotes escaped by backslashes and the octets inside strings
+ * are left out. the decoder jumps between the positions instead of
+ * skipping white space octet by octet.
+ *
+ * positions come a chunk of input at a time, so that the index of
+ * a large input takes constant memory. an octet that does not follow
+ * white space, a structural character or a quote is not listed, so
+ * that the decoder checks the octet after each number and name.
+ *
+ *      wjson::json_index_type index (str);
+ *      std::size_t pos;
+ *      while (index.next (pos))
+ *          std::cout << str[pos];
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace wjson {
+
+class json_index_type {
+public:
+    explicit json_index_type (std::string const& str);
+    bool next (std::size_t& pos);
+
+private:
+    enum { BLOCK_SIZE = 64, CHUNK_SIZE = 16384 };
+
+    std::string const& mstring;
+    std::size_t mblock;             // the next block to classify
+    std::vector<std::size_t> mpositions;
+    std::size_t mcursor;
+    uint64_t minside;               // all ones when a block starts in a string
+    uint64_t mescaped;              // 1 when its first octet is escaped
+    uint64_t mfollow;               // 1 when a token may start at it
+
+    void fill ();
+};
+
+}//namespace wjson
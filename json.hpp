@@ -9,7 +9,42 @@
 
 namespace wjson {
 
-bool decode_json (std::string const& str, value_type& root);
+/* json_handler_type receives the events of decode_json in document order,
+ * so that a handler counts, filters or transcodes a document without
+ * building its tree. the default of each event does nothing.
+ * a handler returns false to stop decoding, and decode_json then
+ * returns false. it may take the characters of a key or a string.
+ * with DECODE_LAZY_NUMBER numbers come to literal, which converts them
+ * for fixnum or flonum by default.
+ *
+ *      struct counter : wjson::json_handler_type {
+ *          std::size_t n = 0;
+ *          bool key (wjson::string_type&) { ++n; return true; }
+ *      } keys;
+ *      wjson::decode_json (input, keys);
+ */
+class json_handler_type {
+public:
+    virtual ~json_handler_type ();
+    virtual bool null ();
+    virtual bool boolean (bool const x);
+    virtual bool fixnum (int64_t const x);
+    virtual bool flonum (double const x);
+    virtual bool literal (std::string const& x);
+    virtual bool string (string_type& x);
+    virtual bool begin_array ();
+    virtual bool end_array ();
+    virtual bool begin_table ();
+    virtual bool key (string_type& x);
+    virtual bool end_table ();
+};
+
+bool decode_json (std::string const& str, json_handler_type& handler,
+    int const flags = 0);
+bool decode_json (std::string const& str, value_type& root,
+    int const flags = 0);
+bool decode_json (std::string const& str, document_type& doc,
+    int const flags = 0);
 
 std::string encode_json (value_type const& value,
     int const padding = 0, int const margin = 0);
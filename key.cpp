@@ -0,0 +1,234 @@
+#include <string>
+#include <utility>
+#include <atomic>
+#include <stdexcept>
+#include "value.hpp"
+
+namespace wjson {
+
+// FNV-1a over code units.
+static std::size_t
+hash_chars (char_type const* p, std::size_t const n)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= static_cast<uint64_t> (p[i]);
+        h *= 1099511628211ULL;
+    }
+    return static_cast<std::size_t> (h);
+}
+
+template<typename S>
+static key_box*
+make_key_box (S&& s)
+{
+    allocator_type<key_box> alloc;
+    key_box* const p = alloc.allocate (1);
+    try {
+        new (p) key_box (std::forward<S> (s));
+    }
+    catch (...) {
+        alloc.deallocate (p, 1);
+        throw;
+    }
+    return p;
+}
+
+key_box::key_box (string_type const& s)
+    : mdata (s), mhash (hash_chars (s.data (), s.size ())), mcount (1)
+{
+}
+
+key_box::key_box (string_type&& s)
+    : mdata (std::move (s)), mhash (hash_chars (mdata.data (), mdata.size ())),
+      mcount (1)
+{
+}
+
+key_type::key_type () noexcept : mbox (nullptr), mdata (nullptr), msize (0)
+{
+}
+
+key_type::key_type (string_type const& s)
+    : mbox (make_key_box (s)), mdata (mbox->mdata.data ()),
+      msize (mbox->mdata.size ())
+{
+}
+
+key_type::key_type (string_type&& s)
+    : mbox (make_key_box (std::move (s))), mdata (mbox->mdata.data ()),
+      msize (mbox->mdata.size ())
+{
+}
+
+key_type::key_type (char_type const* s)
+    : mbox (make_key_box (string_type (s))), mdata (mbox->mdata.data ()),
+      msize (mbox->mdata.size ())
+{
+}
+
+// a copy of a view owns a box. with -DWJSON_ARENA a box in an arena
+// goes with it, so that a copy made out of the arena boxes its own key.
+key_type::key_type (key_type const& x)
+    : mbox (x.mbox), mdata (x.mdata), msize (x.msize)
+{
+#if defined (WJSON_ARENA)
+    if (mbox != nullptr) {
+        arena_type* const arena = allocator_type<key_box>::arena_of (mbox);
+        if (arena != nullptr && arena != current_arena ())
+            mbox = nullptr;
+    }
+#endif
+    if (mbox != nullptr)
+        mbox->mcount.fetch_add (1, std::memory_order_relaxed);
+    else if (mdata != nullptr) {
+        mbox = make_key_box (string_type (x.mdata, x.msize));
+        mdata = mbox->mdata.data ();
+    }
+}
+
+key_type::key_type (key_type&& x) noexcept
+    : mbox (x.mbox), mdata (x.mdata), msize (x.msize)
+{
+    x.mbox = nullptr;
+    x.mdata = nullptr;
+    x.msize = 0;
+}
+
+key_type::~key_type ()
+{
+    release ();
+}
+
+key_type&
+key_type::operator= (key_type const& x)
+{
+    if (this != &x) {
+        key_type tmp (x);
+        *this = std::move (tmp);
+    }
+    return *this;
+}
+
+key_type&
+key_type::operator= (key_type&& x) noexcept
+{
+    if (this != &x) {
+        release ();
+        mbox = x.mbox;
+        mdata = x.mdata;
+        msize = x.msize;
+        x.mbox = nullptr;
+        x.mdata = nullptr;
+        x.msize = 0;
+    }
+    return *this;
+}
+
+key_type
+key_type::view (char_type const* p, std::size_t const n) noexcept
+{
+    key_type k;
+    k.mdata = p;
+    k.msize = n;
+    return k;
+}
+
+key_type
+key_type::view (string_type const& s) noexcept
+{
+    return view (s.data (), s.size ());
+}
+
+std::size_t
+key_type::hash () const
+{
+    return mbox != nullptr ? mbox->mhash : hash_chars (mdata, msize);
+}
+
+bool
+key_type::interned_with (key_type const& x) const
+{
+    return mbox != nullptr && mbox == x.mbox;
+}
+
+string_type const&
+key_type::str () const
+{
+    if (mbox == nullptr)
+        throw std::out_of_range ("key_type::str(): view");
+    return mbox->mdata;
+}
+
+void
+key_type::release () noexcept
+{
+    if (mbox != nullptr
+            && mbox->mcount.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+        mbox->~key_box ();
+        allocator_type<key_box> ().deallocate (mbox, 1);
+    }
+}
+
+bool
+operator== (key_type const& a, key_type const& b)
+{
+    return a.size () == b.size () && (a.data () == b.data ()
+        || std::char_traits<char_type>::compare (a.data (), b.data (), a.size ()) == 0);
+}
+
+bool
+operator!= (key_type const& a, key_type const& b)
+{
+    return ! (a == b);
+}
+
+bool
+operator< (key_type const& a, key_type const& b)
+{
+    if (a.data () == b.data ())
+        return a.size () < b.size ();
+    std::size_t const n = a.size () < b.size () ? a.size () : b.size ();
+    int const c = std::char_traits<char_type>::compare (a.data (), b.data (), n);
+    return c < 0 || (c == 0 && a.size () < b.size ());
+}
+
+intern_pool_type::intern_pool_type () : mkeys ()
+{
+}
+
+key_type
+intern_pool_type::intern (string_type const& s)
+{
+    auto const i = mkeys.find (key_type::view (s));
+    if (i != mkeys.end ())
+        return i->first;
+    key_type k (s);
+    mkeys[k] = true;
+    return k;
+}
+
+key_type
+intern_pool_type::intern (string_type&& s)
+{
+    auto const i = mkeys.find (key_type::view (s));
+    if (i != mkeys.end ())
+        return i->first;
+    key_type k (std::move (s));
+    mkeys[k] = true;
+    return k;
+}
+
+std::size_t
+intern_pool_type::size () const
+{
+    return mkeys.size ();
+}
+
+void
+intern_pool_type::clear ()
+{
+    mkeys.clear ();
+}
+
+}//namespace wjson
@@ -0,0 +1,64 @@
+#include "memory-usage.hpp"
+#include "json.hpp"
+#include "taptests.hpp"
+#include <string>
+
+void
+test_counts (test::simple& ts)
+{
+    wjson::value_type x;
+    wjson::decode_json (R"q({"a":[1,2,{"b":null}],"c":"s","d":true})q", x);
+    wjson::memory_usage_type const m = wjson::memory_usage (x);
+    ts.ok (m.mnodes[wjson::VALUE_TABLE] == 2 && m.mnodes[wjson::VALUE_ARRAY] == 1
+        && m.mnodes[wjson::VALUE_FIXNUM] == 2 && m.mnodes[wjson::VALUE_NULL] == 1
+        && m.mnodes[wjson::VALUE_STRING] == 1 && m.mnodes[wjson::VALUE_BOOLEAN] == 1,
+        "memory_usage nodes by variation");
+    ts.ok (m.mdepth == 3, "memory_usage depth");
+    ts.ok (wjson::memory_usage (wjson::fixnum (1)).mdepth == 0
+        && wjson::memory_usage (wjson::fixnum (1)).mcontainer_bytes == 0,
+        "memory_usage of a scalar");
+}
+
+void
+test_bytes (test::simple& ts)
+{
+    wjson::string_type const text (100, L'x');
+    wjson::value_type x = wjson::array ();
+    x.push_back (wjson::string (text));
+    wjson::memory_usage_type const m = wjson::memory_usage (x);
+    ts.ok (m.mstring_bytes == text.size () * sizeof (wjson::char_type),
+        "memory_usage string bytes");
+    ts.ok (m.mcontainer_bytes >= sizeof (wjson::value_type)
+        && m.mkey_bytes == 0, "memory_usage container bytes");
+    x.reserve (10);
+    ts.ok (wjson::memory_usage (x).mslack_bytes >= 9 * sizeof (wjson::value_type),
+        "memory_usage slack");
+}
+
+void
+test_shared_keys (test::simple& ts)
+{
+    std::string const one (R"q([{"identifier":1}])q");
+    std::string const two (R"q([{"identifier":1},{"identifier":2}])q");
+    wjson::value_type a, b;
+    wjson::decode_json (one, a);
+    wjson::decode_json (two, b);
+    ts.ok (wjson::memory_usage (a).mkey_bytes == wjson::memory_usage (b).mkey_bytes,
+        "memory_usage counts an interned key once");
+    wjson::value_type packed;
+    wjson::decode_json ("[1,2,3]", packed, wjson::DECODE_PACK_ARRAY);
+    ts.ok (wjson::memory_usage (packed).mnodes[wjson::VALUE_FIXNUM] == 3,
+        "memory_usage counts packed elements");
+}
+
+int
+main ()
+{
+    test::simple ts (8);
+
+    test_counts (ts);
+    test_bytes (ts);
+    test_shared_keys (ts);
+
+    return ts.done_testing ();
+}
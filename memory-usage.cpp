@@ -0,0 +1,140 @@
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <unordered_set>
+#include "memory-usage.hpp"
+
+namespace wjson {
+
+// whether the characters of a string live in the heap, not in itself.
+template<typename S>
+static bool
+on_heap (S const& s)
+{
+    char const* const p = reinterpret_cast<char const*> (s.data ());
+    char const* const self = reinterpret_cast<char const*> (&s);
+    return p < self || self + sizeof (s) <= p;
+}
+
+static void
+add_string (string_type const& s, std::size_t& bytes, std::size_t& slack)
+{
+    if (! on_heap (s))
+        return;
+    bytes += s.size () * sizeof (char_type);
+    slack += (s.capacity () + 1 - s.size ()) * sizeof (char_type);
+}
+
+template<typename V>
+static void
+add_vector (V const& v, std::size_t const unit, memory_usage_type& m)
+{
+    m.mcontainer_bytes += v.size () * unit;
+    m.mslack_bytes += (v.capacity () - v.size ()) * unit;
+}
+
+memory_usage_type
+memory_usage (value_type const& root)
+{
+    memory_usage_type m {0, 0, 0, 0, {0}, 0};
+    std::unordered_set<void const*> seen;
+    std::vector<std::pair<value_type const*, std::size_t>> stack;
+    stack.push_back (std::make_pair (&root, 0));
+    while (! stack.empty ()) {
+        value_type const& x = *stack.back ().first;
+        std::size_t const depth = stack.back ().second;
+        stack.pop_back ();
+        ++m.mnodes[x.tag ()];
+        switch (x.tag ()) {
+        case VALUE_FIXNUM:
+        case VALUE_FLONUM:
+            if (x.literal () != nullptr && seen.insert (x.literal ()).second) {
+                literal_string_type const& s = *x.literal ();
+                m.mcontainer_bytes += sizeof (value_box<number_literal_type>);
+                if (on_heap (s)) {
+                    m.mstring_bytes += s.size ();
+                    m.mslack_bytes += s.capacity () + 1 - s.size ();
+                }
+            }
+            break;
+        case VALUE_DATETIME:
+            if (seen.insert (&x.datetime ()).second)
+                m.mcontainer_bytes += sizeof (value_box<datetime_type>);
+            break;
+        case VALUE_STRING:
+            if (seen.insert (&x.string ()).second) {
+                m.mcontainer_bytes += sizeof (value_box<string_type>);
+                add_string (x.string (), m.mstring_bytes, m.mslack_bytes);
+            }
+            break;
+        case VALUE_ARRAY:
+            m.mdepth = std::max (m.mdepth, depth + 1);
+            switch (x.packed ()) {
+            case PACK_NONE:
+                if (! seen.insert (&x.array ()).second)
+                    break;
+                m.mcontainer_bytes += sizeof (value_box<array_value_type>);
+                add_vector (x.array (), sizeof (value_type), m);
+                for (auto const& e : x.array ())
+                    stack.push_back (std::make_pair (&e, depth + 1));
+                break;
+            case PACK_BOOLEAN:
+                if (! seen.insert (&x.booleans ()).second)
+                    break;
+                m.mcontainer_bytes += sizeof (value_box<boolean_array_type>)
+                    + (x.booleans ().size () + 7) / 8;
+                m.mslack_bytes += (x.booleans ().capacity () - x.booleans ().size ()) / 8;
+                m.mnodes[VALUE_BOOLEAN] += x.size ();
+                break;
+            case PACK_FIXNUM:
+                if (! seen.insert (&x.fixnums ()).second)
+                    break;
+                m.mcontainer_bytes += sizeof (value_box<fixnum_array_type>);
+                add_vector (x.fixnums (), sizeof (int64_t), m);
+                m.mnodes[VALUE_FIXNUM] += x.size ();
+                break;
+            case PACK_FLONUM:
+                if (! seen.insert (&x.flonums ()).second)
+                    break;
+                m.mcontainer_bytes += sizeof (value_box<flonum_array_type>);
+                add_vector (x.flonums (), sizeof (double), m);
+                m.mnodes[VALUE_FLONUM] += x.size ();
+                break;
+            default:
+                break;
+            }
+            break;
+        case VALUE_TABLE:
+            m.mdepth = std::max (m.mdepth, depth + 1);
+            if (! seen.insert (&x.table ()).second)
+                break;
+            m.mcontainer_bytes += sizeof (value_box<table_value_type>);
+#if defined (WJSON_HASH_TABLE)
+            m.mcontainer_bytes += x.table ().size () * sizeof (table_value_type::value_type)
+                + x.table ().index_bytes ();
+            m.mslack_bytes += (x.table ().capacity () - x.table ().size ())
+                * sizeof (table_value_type::value_type);
+#else
+            m.mcontainer_bytes += x.table ().size ()
+                * (sizeof (table_value_type::value_type) + 4 * sizeof (void*));
+#endif
+            for (auto const& e : x.table ()) {
+                string_type const& key = e.first.str ();
+                if (seen.insert (&key).second) {
+                    std::size_t slack = 0;
+                    m.mkey_bytes += sizeof (key_box);
+                    add_string (key, m.mkey_bytes, slack);
+                    m.mkey_bytes += slack;
+                }
+                stack.push_back (std::make_pair (&e.second, depth + 1));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return m;
+}
+
+}//namespace wjson
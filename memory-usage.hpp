@@ -0,0 +1,31 @@
+#pragma once
+
+/* memory_usage walks a tree and adds up the bytes it holds.
+ *
+ *      wjson::memory_usage_type m = wjson::memory_usage (doc.root ());
+ *      std::cout << m.mstring_bytes + m.mkey_bytes + m.mcontainer_bytes
+ *          + m.mslack_bytes << " bytes, depth " << m.mdepth;
+ *
+ * the numbers come from sizes and capacities of the containers, not
+ * from the allocator, so that they leave out its headers and rounding.
+ * nodes of std::map tables are estimated as an entry and four words.
+ * a box shared by copies or an interned key is counted once.
+ */
+
+#include <cstddef>
+#include "value.hpp"
+
+namespace wjson {
+
+struct memory_usage_type {
+    std::size_t mstring_bytes;      // characters of strings on the heap
+    std::size_t mkey_bytes;         // key boxes and their characters
+    std::size_t mcontainer_bytes;   // boxes, elements, entries and indexes
+    std::size_t mslack_bytes;       // unused capacity of strings and vectors
+    std::size_t mnodes[VALUE_TABLE + 1];    // values by variation
+    std::size_t mdepth;             // levels of nested arrays and tables
+};
+
+memory_usage_type memory_usage (value_type const& root);
+
+}//namespace wjson
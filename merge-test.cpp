@@ -0,0 +1,87 @@
+#include "merge.hpp"
+#include "json.hpp"
+#include "taptests.hpp"
+#include <string>
+
+static wjson::value_type
+json (std::string const& input)
+{
+    wjson::value_type x;
+    wjson::decode_json (input, x);
+    return x;
+}
+
+void
+test_override (test::simple& ts)
+{
+    wjson::value_type dst = json (R"q({"a":1,"b":{"c":2,"d":[1]},"e":"x"})q");
+    wjson::value_type src = json (R"q({"a":3,"b":{"d":[2],"f":4},"g":[5]})q");
+    wjson::merge (dst, std::move (src));
+    ts.ok (dst == json (R"q({"a":3,"b":{"c":2,"d":[2],"f":4},"e":"x","g":[5]})q"),
+        "merge override");
+    ts.ok (src.tag () == wjson::VALUE_NULL, "merge leaves source null");
+}
+
+void
+test_keep (test::simple& ts)
+{
+    wjson::value_type dst = json (R"q({"a":1,"b":{"c":2}})q");
+    wjson::merge (dst, json (R"q({"a":3,"b":{"c":4,"d":5}})q"), wjson::MERGE_KEEP);
+    ts.ok (dst == json (R"q({"a":1,"b":{"c":2,"d":5}})q"), "merge keep");
+}
+
+void
+test_error (test::simple& ts)
+{
+    wjson::value_type dst = json (R"q({"a":1,"b":{"c":2}})q");
+    wjson::merge (dst, json (R"q({"a":1,"d":3})q"), wjson::MERGE_ERROR);
+    ts.ok (dst == json (R"q({"a":1,"b":{"c":2},"d":3})q"),
+        "merge error passes equal nodes");
+    bool thrown = false;
+    try {
+        wjson::merge (dst, json (R"q({"b":{"c":"x"}})q"), wjson::MERGE_ERROR);
+    }
+    catch (std::out_of_range const&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "merge error throws on conflict");
+}
+
+void
+test_append (test::simple& ts)
+{
+    wjson::value_type dst;
+    wjson::decode_json (R"q({"list":[1,2],"s":"a"})q", dst, wjson::DECODE_PACK_ARRAY);
+    wjson::merge (dst, json (R"q({"list":[3,"x"],"s":"b"})q"),
+        wjson::MERGE_KEEP | wjson::MERGE_APPEND);
+    ts.ok (dst == json (R"q({"list":[1,2,3,"x"],"s":"a"})q"), "merge append");
+}
+
+void
+test_layers (test::simple& ts)
+{
+    wjson::intern_pool_type pool;
+    wjson::value_type dst = wjson::table ();
+    wjson::value_type src = wjson::table ();
+    {
+        wjson::intern_scope keys (pool);
+        src.set (L"name", wjson::string (L"layer"));
+    }
+    wjson::merge (dst, std::move (src));
+    ts.ok (dst.table ().begin ()->first.interned_with (pool.intern (L"name")),
+        "merge moves keys");
+}
+
+int
+main ()
+{
+    test::simple ts (7);
+
+    test_override (ts);
+    test_keep (ts);
+    test_error (ts);
+    test_append (ts);
+    test_layers (ts);
+
+    return ts.done_testing ();
+}
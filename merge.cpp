@@ -0,0 +1,46 @@
+#include <utility>
+#include <stdexcept>
+#include "merge.hpp"
+
+namespace wjson {
+
+static void merge_node (value_type& dst, value_type& src, int const policy);
+
+void
+merge (value_type& dst, value_type&& src, int const policy)
+{
+    merge_node (dst, src, policy);
+    src = value_type ();
+}
+
+static void
+merge_node (value_type& dst, value_type& src, int const policy)
+{
+    if (dst.tag () == VALUE_TABLE && src.tag () == VALUE_TABLE) {
+        table_value_type& from = src.table ();
+        table_value_type& to = dst.table ();
+        for (auto& e : from) {
+            auto const i = to.find (e.first);
+            if (i == to.end ())
+                to.insert (std::make_pair (e.first, std::move (e.second)));
+            else
+                merge_node (i->second, e.second, policy);
+        }
+    }
+    else if ((policy & MERGE_APPEND) != 0
+            && dst.tag () == VALUE_ARRAY && src.tag () == VALUE_ARRAY) {
+        array_value_type& from = src.array ();
+        array_value_type& to = dst.array ();
+        to.reserve (to.size () + from.size ());
+        for (auto& x : from)
+            to.push_back (std::move (x));
+    }
+    else if (dst == src)
+        return;
+    else if ((policy & MERGE_ERROR) != 0)
+        throw std::out_of_range ("merge(): conflict");
+    else if ((policy & MERGE_KEEP) == 0)
+        dst = std::move (src);
+}
+
+}//namespace wjson
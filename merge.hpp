@@ -0,0 +1,37 @@
+#pragma once
+
+/* merge moves the nodes of a source tree into a destination tree.
+ *
+ *      wjson::value_type config = std::move (defaults);
+ *      for (auto& layer : overrides)
+ *          wjson::merge (config, std::move (layer), wjson::MERGE_APPEND);
+ *
+ * tables merge entry by entry, and the entries only in the source
+ * move into the destination with their keys shared.
+ * the other pairs of nodes conflict unless they are equal, and
+ * the policy decides the result:
+ *
+ *      MERGE_OVERRIDE  the source node replaces the destination one.
+ *      MERGE_KEEP      the destination node stays.
+ *      MERGE_ERROR     throws out_of_range, and leaves the entries
+ *                      merged before the conflict.
+ *
+ * add MERGE_APPEND to one of them to append the elements of a source
+ * array to the destination array instead.
+ * the source is null after merge.
+ */
+
+#include "value.hpp"
+
+namespace wjson {
+
+enum {
+    MERGE_OVERRIDE = 0,
+    MERGE_KEEP = 1,
+    MERGE_ERROR = 2,
+    MERGE_APPEND = 4,
+};
+
+void merge (value_type& dst, value_type&& src, int const policy = MERGE_OVERRIDE);
+
+}//namespace wjson
@@ -160,6 +160,17 @@ test_sections_non_empty_lists (test::simple& ts)
     ts.ok (wjson::decode_json (input_json, param), "sections_non_empty_lists decode");
     mustache.render (param, got);
     ts.ok (got.str () == expected, "sections_non_empty_lists render");
+
+    wjson::mustache packed;
+    wjson::value_type packed_param;
+    std::ostringstream packed_got;
+    packed.assemble ("{{#n}}<i>{{/n}}");
+    wjson::decode_json ("{\"n\":[1,2,3]}", packed_param,
+        wjson::DECODE_PACK_ARRAY);
+    packed.render (packed_param, packed_got);
+    ts.ok (packed_got.str () == "<i><i><i>"
+        && packed_param.get (L"n").packed () == wjson::PACK_FIXNUM,
+        "sections_non_empty_lists packed render");
 }
 
 void
@@ -250,7 +261,7 @@ test_comments (test::simple& ts)
 int
 main ()
 {
-    test::simple ts (21);
+    test::simple ts (22);
 
     test_typical (ts);
     test_variables (ts);
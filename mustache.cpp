@@ -136,7 +136,7 @@ mustache::skip_comment (std::size_t const pos, span_type& op) const
 void
 mustache::render (wjson::value_type& param, std::ostream& output) const
 {
-    std::vector<wjson::value_type *> env;
+    std::vector<wjson::value_type const*> env;
     env.push_back (&param);
     render_block (0, env, output);
     env.back () = nullptr;
@@ -144,10 +144,10 @@ mustache::render (wjson::value_type& param, std::ostream& output) const
 
 void
 mustache::render_block (std::size_t ip,
-    std::vector<wjson::value_type *>& env, std::ostream& output) const
+    std::vector<wjson::value_type const*>& env, std::ostream& output) const
 {
     std::wstring::const_iterator const s = m_source.cbegin ();
-    std::wstring key;
+    string_type key;
     std::size_t const limit = ip + m_program[ip].size + 1;
     ++ip;
     for (; ip < limit; ++ip) {
@@ -160,64 +160,64 @@ mustache::render_block (std::size_t ip,
             ;
         }
         else {
-            key.assign (s + op.first, s + op.last);
-            wjson::value_type it;
+            key.clear ();
+            for (std::size_t i = op.first; i < op.last; ++i)
+                append_code (key, static_cast<std::uint32_t> (s[i]));
+            wjson::value_type const* it = nullptr;
             bool const exists = lookup (env, key, it);
-            if (! exists || it.tag () == wjson::VALUE_NULL) {
+            if (! exists || it->tag () == wjson::VALUE_NULL) {
                 if (L'^' == op.code)
                     render_block (ip, env, output);
             }
-            else if (it.tag () == wjson::VALUE_BOOLEAN) {
-                if (L'^' == op.code && ! it.boolean ())
+            else if (it->tag () == wjson::VALUE_BOOLEAN) {
+                if (L'^' == op.code && ! it->boolean ())
                     render_block (ip, env, output);
-                else if (L'#' == op.code && it.boolean ())
+                else if (L'#' == op.code && it->boolean ())
                     render_block (ip, env, output);
             }
-            else if (it.tag () == wjson::VALUE_FIXNUM) {
+            else if (it->tag () == wjson::VALUE_FIXNUM) {
                 if (L'$' == op.code || L'&' == op.code)
-                    output << it.fixnum ();
+                    output << it->fixnum ();
             }
-            else if (it.tag () == wjson::VALUE_FLONUM) {
+            else if (it->tag () == wjson::VALUE_FLONUM) {
                 if (L'$' == op.code || L'&' == op.code)
-                    render_flonum (it.flonum (), output);
+                    render_flonum (it->flonum (), output);
             }
-            else if (it.tag () == wjson::VALUE_DATETIME) {
-                if (L'&' == op.code)
-                    render_string (it.datetime (), output);
-                else if (L'$' == op.code)
-                    render_html (it.datetime (), output);
+            else if (it->tag () == wjson::VALUE_DATETIME) {
+                if (L'&' == op.code || L'$' == op.code)
+                    output << wjson::encode_datetime (it->datetime ());
                 else if (L'#' == op.code)
                     render_block (ip, env, output);
             }
-            else if (it.tag () == wjson::VALUE_STRING) {
-                bool const is_empty = it.size () == 0;
+            else if (it->tag () == wjson::VALUE_STRING) {
+                bool const is_empty = it->size () == 0;
                 if (L'&' == op.code)
-                    render_string (it.string (), output);
+                    render_string (it->string (), output);
                 else if (L'$' == op.code)
-                    render_html (it.string (), output);
+                    render_html (it->string (), output);
                 else if (L'^' == op.code && is_empty)
                     render_block (ip, env, output);
                 else if (L'#' == op.code && ! is_empty)
                     render_block (ip, env, output);
             }
-            else if (it.tag () == wjson::VALUE_TABLE) {
-                bool const is_empty = it.size () == 0;
+            else if (it->tag () == wjson::VALUE_TABLE) {
+                bool const is_empty = it->size () == 0;
                 if (L'^' == op.code && is_empty) {
                     render_block (ip, env, output);
                 }
                 else if (L'#' == op.code && ! is_empty) {
-                    env.push_back (&it);
+                    env.push_back (it);
                     render_block (ip, env, output);
                     env.back () = nullptr;
                     env.pop_back ();
                 }
             }
-            else if (it.tag () == wjson::VALUE_ARRAY) {
-                if (L'^' == op.code && it.size () == 0) {
+            else if (it->tag () == wjson::VALUE_ARRAY) {
+                if (L'^' == op.code && it->size () == 0) {
                     render_block (ip, env, output);
                 }
                 else if (L'#' == op.code) {
-                    for (auto& x : it.array ()) {
+                    for (auto const& x : it->elements ()) {
                         env.push_back (&x);
                         render_block (ip, env, output);
                         env.back () = nullptr;
@@ -232,14 +232,14 @@ mustache::render_block (std::size_t ip,
 }
 
 bool
-mustache::lookup (std::vector<wjson::value_type *>& env,
-    std::wstring const& key, wjson::value_type& it) const
+mustache::lookup (std::vector<wjson::value_type const*>& env,
+    string_type const& key, wjson::value_type const*& it) const
 {
     for (int i = env.size (); i > 0; --i)
         if (env[i - 1]->tag () == wjson::VALUE_TABLE) {
-            auto j = env[i - 1]->table ().find (key);
+            auto j = env[i - 1]->table ().find (wjson::key_type::view (key));
             if (j != env[i - 1]->table ().end ()) {
-                it = j->second;
+                it = &j->second;
                 return true;
             }
         }
@@ -258,21 +258,19 @@ mustache::render_flonum (double const x, std::ostream& output) const
 }
 
 void
-mustache::render_string (std::wstring const& str, std::ostream& output) const
+mustache::render_string (string_type const& str, std::ostream& output) const
 {
-    for (std::wstring::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
-        uint32_t const uc = static_cast<uint32_t> (*s);
-        encode_utf8 (output, uc);
-    }
+    for (string_type::const_iterator s = str.cbegin (); s < str.cend (); ++s)
+        encode_utf8 (output, *s);
 }
 
 void
-mustache::render_html (std::wstring const& str, std::ostream& output) const
+mustache::render_html (string_type const& str, std::ostream& output) const
 {
-    for (std::wstring::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
+    for (string_type::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
         uint32_t const uc = static_cast<uint32_t> (*s);
         switch (uc) {
-        default: encode_utf8 (output, uc); break;
+        default: encode_utf8 (output, *s); break;
         case '&': output << "&amp;"; break;
         case '<': output << "&lt;"; break;
         case '>': output << "&gt;"; break;
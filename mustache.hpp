@@ -43,13 +43,13 @@ protected:
     bool parse (void);
     std::size_t match (std::size_t const pos, span_type& op) const;
     std::size_t skip_comment (std::size_t const pos, span_type& op) const;
-    void render_block (std::size_t ip, std::vector<wjson::value_type *>& env,
-        std::ostream& output) const;
-    bool lookup (std::vector<wjson::value_type *>& env, std::wstring const& key,
-        wjson::value_type& it) const;
+    void render_block (std::size_t ip,
+        std::vector<wjson::value_type const*>& env, std::ostream& output) const;
+    bool lookup (std::vector<wjson::value_type const*>& env,
+        string_type const& key, wjson::value_type const*& it) const;
     void render_flonum (double const x, std::ostream& out) const;
-    void render_string (std::wstring const& str, std::ostream& out) const;
-    void render_html (std::wstring const& str, std::ostream& out) const;
+    void render_string (string_type const& str, std::ostream& out) const;
+    void render_html (string_type const& str, std::ostream& out) const;
 
 private:
     mustache (mustache const&);
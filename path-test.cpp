@@ -0,0 +1,104 @@
+#include "path.hpp"
+#include "json.hpp"
+#include "taptests.hpp"
+#include <string>
+
+static wjson::value_type
+make_config ()
+{
+    wjson::value_type config = wjson::table ();
+    config[L"server"][L"host"] = wjson::string (L"localhost");
+    config[L"server"][L"ports"] = wjson::fixnums ({8001, 8002});
+    config[L"a/b"][L"m~n"] = wjson::fixnum (1);
+    config[L"list"] = wjson::array ();
+    config[L"list"][0] = wjson::table ();
+    config[L"list"][0][L"0"] = wjson::string (L"zero");
+    return config;
+}
+
+void
+test_dotted (test::simple& ts)
+{
+    wjson::value_type config = make_config ();
+    wjson::value_type const& c = config;
+    wjson::path_type const host (L"server.host");
+    ts.ok (host.size () == 2 && host.get (c).string () == L"localhost",
+        "dotted path");
+    wjson::path_type const item (L"list.0.0");
+    ts.ok (item.exists (c) && item.get (c).string () == L"zero",
+        "dotted path index and digit key");
+    ts.ok (wjson::path_type (L"").find (c) == &c, "empty path is root");
+    ts.ok (! wjson::path_type (L"server.port").find (c)
+        && ! wjson::path_type (L"server.host.x").find (c)
+        && ! wjson::path_type (L"list.1").find (c)
+        && ! wjson::path_type (L"list.01").find (c), "dotted path misses");
+}
+
+void
+test_pointer (test::simple& ts)
+{
+    wjson::value_type config = make_config ();
+    wjson::value_type const& c = config;
+    ts.ok (wjson::path_type::pointer (L"/a~1b/m~0n").get (c).fixnum () == 1,
+        "pointer escapes");
+    wjson::path_type const port = wjson::path_type::pointer (L"/server/ports/1");
+    ts.ok (! port.find (c), "const pointer into packed array");
+    ts.ok (port.get (config).fixnum () == 8002
+        && config.get (L"server").get (L"ports").packed () == wjson::PACK_NONE,
+        "pointer unpacks packed array");
+    bool thrown = false;
+    try {
+        wjson::path_type::pointer (L"server");
+    }
+    catch (std::out_of_range const&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "pointer without leading slash");
+}
+
+void
+test_push_back (test::simple& ts)
+{
+    wjson::value_type config = make_config ();
+    wjson::path_type path;
+    path.push_back (L"list").push_back (0).push_back (L"0");
+    ts.ok (path.size () == 3 && path.get (config).string () == L"zero",
+        "push_back segments");
+    wjson::value_type other = make_config ();
+    other[L"list"][0][L"0"] = wjson::string (L"other");
+    ts.ok (path.get (other).string () == L"other", "same path on other root");
+    path.get (config) = wjson::fixnum (0);
+    ts.ok (config[L"list"][0][L"0"].fixnum () == 0, "write through path");
+}
+
+void
+test_packed (test::simple& ts)
+{
+    wjson::value_type doc;
+    wjson::decode_json (R"q({"ports":[8001,8002],"on":[true,false]})q", doc,
+        wjson::DECODE_PACK_ARRAY);
+    wjson::value_type const& root = doc;
+    wjson::path_type const port (L"ports.1");
+    ts.ok (root.get (L"ports").packed () == wjson::PACK_FIXNUM
+        && port.exists (root) && ! wjson::path_type (L"ports.2").exists (root),
+        "exists element of packed array");
+    ts.ok (port.value (root).fixnum () == 8002
+        && ! wjson::path_type::pointer (L"/on/1").value (root).boolean ()
+        && root.get (L"on").element (0).boolean (),
+        "value of element of packed array");
+    ts.ok (root.get (L"ports").packed () == wjson::PACK_FIXNUM,
+        "const path keeps array packed");
+}
+
+int
+main ()
+{
+    test::simple ts (14);
+
+    test_dotted (ts);
+    test_pointer (ts);
+    test_push_back (ts);
+    test_packed (ts);
+
+    return ts.done_testing ();
+}
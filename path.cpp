@@ -0,0 +1,190 @@
+#include <vector>
+#include <string>
+#include <utility>
+#include <stdexcept>
+#include "path.hpp"
+
+namespace wjson {
+
+path_type::path_type () : msegments ()
+{
+}
+
+path_type::path_type (string_type const& dotted) : msegments ()
+{
+    if (dotted.empty ())
+        return;
+    std::size_t first = 0;
+    for (;;) {
+        std::size_t const last = dotted.find ('.', first);
+        if (last == string_type::npos) {
+            push_segment (dotted.substr (first));
+            break;
+        }
+        push_segment (dotted.substr (first, last - first));
+        first = last + 1;
+    }
+}
+
+path_type
+path_type::pointer (string_type const& str)
+{
+    path_type path;
+    if (str.empty ())
+        return path;
+    if (str[0] != '/')
+        throw std::out_of_range ("path_type::pointer(str): invalid");
+    string_type key;
+    for (std::size_t i = 1; i <= str.size (); ++i) {
+        if (i == str.size () || str[i] == '/') {
+            path.push_segment (std::move (key));
+            key.clear ();
+        }
+        else if (str[i] != '~')
+            key.push_back (str[i]);
+        else if (i + 1 < str.size () && (str[i + 1] == '0' || str[i + 1] == '1'))
+            key.push_back (str[++i] == '0' ? '~' : '/');
+        else
+            throw std::out_of_range ("path_type::pointer(str): invalid escape");
+    }
+    return path;
+}
+
+path_type&
+path_type::push_back (string_type const& key)
+{
+    msegments.push_back ({key_type (key), 0, false});
+    return *this;
+}
+
+path_type&
+path_type::push_back (std::size_t const idx)
+{
+    string_type key;
+    for (std::size_t x = idx; ; x /= 10) {
+        key.insert (key.begin (), static_cast<char_type> ('0' + x % 10));
+        if (x < 10)
+            break;
+    }
+    msegments.push_back ({key_type (std::move (key)), idx, true});
+    return *this;
+}
+
+std::size_t
+path_type::size () const
+{
+    return msegments.size ();
+}
+
+// digits without a leading zero are also an index.
+void
+path_type::push_segment (string_type&& key)
+{
+    bool index = ! key.empty () && key.size () < 19
+        && (key.size () == 1 || key[0] != '0');
+    std::size_t idx = 0;
+    for (std::size_t i = 0; index && i < key.size (); ++i) {
+        index = '0' <= key[i] && key[i] <= '9';
+        idx = idx * 10 + (key[i] - '0');
+    }
+    msegments.push_back ({key_type (std::move (key)), index ? idx : 0, index});
+}
+
+static value_type const*
+child (value_type const& node, path_segment_type const& seg)
+{
+    if (table_value_type const* const table = node.if_table ()) {
+        auto const i = table->find (seg.mkey);
+        return i == table->end () ? nullptr : &i->second;
+    }
+    return seg.mindex ? node.find (seg.midx) : nullptr;
+}
+
+// an element of a packed array has no node, so that the last segment
+// is left to the caller.
+value_type const*
+path_type::parent (value_type const& root) const
+{
+    value_type const* node = &root;
+    for (std::size_t i = 0; node != nullptr && i + 1 < msegments.size (); ++i)
+        node = child (*node, msegments[i]);
+    return node;
+}
+
+value_type const*
+path_type::find (value_type const& root) const
+{
+    if (msegments.empty ())
+        return &root;
+    value_type const* const node = parent (root);
+    return node == nullptr ? nullptr : child (*node, msegments.back ());
+}
+
+value_type*
+path_type::find (value_type& root) const
+{
+    value_type* node = &root;
+    for (auto const& seg : msegments) {
+        if (node->tag () == VALUE_TABLE) {
+            table_value_type& table = node->table ();
+            auto const i = table.find (seg.mkey);
+            if (i == table.end ())
+                return nullptr;
+            node = &i->second;
+        }
+        else if (seg.mindex)
+            node = node->find (seg.midx);
+        else
+            return nullptr;
+        if (node == nullptr)
+            return nullptr;
+    }
+    return node;
+}
+
+value_type const&
+path_type::get (value_type const& root) const
+{
+    value_type const* const node = find (root);
+    if (node == nullptr)
+        throw std::out_of_range ("path_type::get(root)const: not exists");
+    return *node;
+}
+
+value_type&
+path_type::get (value_type& root) const
+{
+    value_type* const node = find (root);
+    if (node == nullptr)
+        throw std::out_of_range ("path_type::get(root): not exists");
+    return *node;
+}
+
+value_type
+path_type::value (value_type const& root) const
+{
+    if (msegments.empty ())
+        return root;
+    value_type const* const node = parent (root);
+    path_segment_type const& seg = msegments.back ();
+    if (node != nullptr && node->packed () != PACK_NONE && seg.mindex
+            && seg.midx < node->size ())
+        return node->element (seg.midx);
+    return get (root);
+}
+
+bool
+path_type::exists (value_type const& root) const
+{
+    if (msegments.empty ())
+        return true;
+    value_type const* const node = parent (root);
+    if (node == nullptr)
+        return false;
+    path_segment_type const& seg = msegments.back ();
+    if (node->packed () != PACK_NONE)
+        return seg.mindex && seg.midx < node->size ();
+    return child (*node, seg) != nullptr;
+}
+
+}//namespace wjson
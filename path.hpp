@@ -0,0 +1,57 @@
+#pragma once
+
+/* path_type is a lookup path compiled once and resolved against
+ * any value_type. its keys are key_type with cached hashes,
+ * so that resolving a path neither parses nor allocates.
+ *
+ *      static wjson::path_type const port (L"server.ports.0");
+ *      static wjson::path_type const name
+ *          = wjson::path_type::pointer (L"/owner/name");
+ *      if (wjson::value_type const* p = port.find (config))
+ *          listen (p->fixnum ());
+ *
+ * the dotted form splits at every '.' and has no escapes.
+ * the pointer form is RFC 6901 JSON Pointer with ~0 and ~1 escapes.
+ * a segment of digits selects an array element or a table entry
+ * by the type of the node.
+ */
+
+#include <vector>
+#include "value.hpp"
+
+namespace wjson {
+
+struct path_segment_type {
+    key_type mkey;
+    std::size_t midx;
+    bool mindex;
+};
+
+class path_type {
+public:
+    path_type ();
+    explicit path_type (string_type const& dotted);
+    static path_type pointer (string_type const& str);
+    path_type& push_back (string_type const& key);
+    path_type& push_back (std::size_t const idx);
+    std::size_t size () const;
+
+    // find returns nullptr when the path does not exist.
+    // the non-const one unpacks packed arrays on the way, and
+    // the const one returns nullptr on an element of a packed array,
+    // which value copies and exists reports.
+    value_type const* find (value_type const& root) const;
+    value_type* find (value_type& root) const;
+    value_type const& get (value_type const& root) const;
+    value_type& get (value_type& root) const;
+    value_type value (value_type const& root) const;
+    bool exists (value_type const& root) const;
+
+private:
+    std::vector<path_segment_type> msegments;
+
+    void push_segment (string_type&& key);
+    value_type const* parent (value_type const& root) const;
+};
+
+}//namespace wjson
@@ -0,0 +1,44 @@
+#include "value.hpp"
+#include "reclaimer.hpp"
+#include "taptests.hpp"
+#include <string>
+#include <utility>
+
+void
+test_deep (test::simple& ts)
+{
+    wjson::value_type root;
+    wjson::value_type* p = &root;
+    for (int i = 0; i < 1000000; ++i) {
+        *p = wjson::array ();
+        p = &p->emplace_back (wjson::table ()).emplace (L"x");
+    }
+    *p = wjson::string (L"leaf");
+    root = wjson::null ();
+    ts.ok (root.tag () == wjson::VALUE_NULL, "destroy 1000000 nested levels");
+}
+
+void
+test_reclaimer (test::simple& ts)
+{
+    wjson::reclaimer_type reclaimer;
+    wjson::value_type x = wjson::array ();
+    for (int i = 0; i < 1000; ++i)
+        x.emplace_back (wjson::table ()).set (L"i", wjson::fixnum (i));
+    reclaimer.retire (std::move (x));
+    ts.ok (x.tag () == wjson::VALUE_NULL, "retire takes value");
+    reclaimer.retire (wjson::string (L"foo"));
+    reclaimer.wait ();
+    ts.ok (true, "wait for retired values");
+}
+
+int
+main ()
+{
+    test::simple ts (3);
+
+    test_deep (ts);
+    test_reclaimer (ts);
+
+    return ts.done_testing ();
+}
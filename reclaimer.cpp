@@ -0,0 +1,64 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include "reclaimer.hpp"
+
+namespace wjson {
+
+reclaimer_type::reclaimer_type ()
+    : mmutex (), mready (), mdone (), mqueue (), mbusy (false), mstop (false),
+      mthread (&reclaimer_type::run, this)
+{
+}
+
+reclaimer_type::~reclaimer_type ()
+{
+    {
+        std::lock_guard<std::mutex> lock (mmutex);
+        mstop = true;
+    }
+    mready.notify_one ();
+    mthread.join ();
+}
+
+void
+reclaimer_type::retire (value_type&& x)
+{
+    {
+        std::lock_guard<std::mutex> lock (mmutex);
+        mqueue.push_back (std::move (x));
+    }
+    mready.notify_one ();
+}
+
+// blocks until the values retired so far are destroyed.
+void
+reclaimer_type::wait ()
+{
+    std::unique_lock<std::mutex> lock (mmutex);
+    mdone.wait (lock, [this] { return mqueue.empty () && ! mbusy; });
+}
+
+// takes the whole queue at once and destroys it out of the lock.
+void
+reclaimer_type::run ()
+{
+    std::vector<value_type> batch;
+    std::unique_lock<std::mutex> lock (mmutex);
+    for (;;) {
+        mready.wait (lock, [this] { return mstop || ! mqueue.empty (); });
+        if (mqueue.empty ())
+            break;
+        batch.swap (mqueue);
+        mbusy = true;
+        lock.unlock ();
+        batch.clear ();
+        lock.lock ();
+        mbusy = false;
+        mdone.notify_all ();
+    }
+}
+
+}//namespace wjson
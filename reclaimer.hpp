@@ -0,0 +1,46 @@
+#pragma once
+
+/* reclaimer_type destroys retired values on a background thread,
+ * so that dropping a huge tree does not block the caller.
+ *
+ *      wjson::reclaimer_type reclaimer;
+ *      ...
+ *      config.swap (new_config);
+ *      reclaimer.retire (std::move (new_config));   // the old one
+ *
+ * the destructor waits until every retired value is destroyed.
+ * do not retire values made in the arena of a living document_type
+ * that may go away before the reclaimer.
+ */
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "value.hpp"
+
+namespace wjson {
+
+class reclaimer_type {
+public:
+    reclaimer_type ();
+    ~reclaimer_type ();
+    void retire (value_type&& x);
+    void wait ();
+
+private:
+    std::mutex mmutex;
+    std::condition_variable mready;
+    std::condition_variable mdone;
+    std::vector<value_type> mqueue;
+    bool mbusy;
+    bool mstop;
+    std::thread mthread;
+
+    void run ();
+
+    reclaimer_type (reclaimer_type const&);
+    reclaimer_type& operator= (reclaimer_type const&);
+};
+
+}//namespace wjson
@@ -1,6 +1,7 @@
 #include "value.hpp"
 #include "taptests.hpp"
 #include <sstream>
+#include <string>
 
 void
 wjson_setter_test (test::simple& ts)
@@ -87,13 +88,82 @@ fruit_test (test::simple& ts)
         "fruit[1]variety[0].name plantain");
 }
 
+void
+test_resolved (test::simple& ts)
+{
+    wjson::value_type doc = wjson::table ();
+    wjson::setter_type deep = doc[L"a"][L"b"][L"c"][L"d"][L"e"][0][L"f"];
+    ts.ok (! deep.exists () && deep.tag () == wjson::VALUE_NULL,
+        "setter deeper than inline segments");
+    deep = wjson::fixnum (1);
+    ts.ok (deep.fixnum () == 1
+        && doc[L"a"][L"b"][L"c"][L"d"][L"e"][0][L"f"].fixnum () == 1,
+        "setter makes containers on write");
+    deep = wjson::fixnum (2);
+    ts.ok (deep.fixnum () == 2 && deep.lookup ()->tag () == wjson::VALUE_TABLE,
+        "setter writes resolved node");
+    wjson::setter_type e = doc[L"a"][L"b"][L"c"][L"d"][L"e"];
+    ts.ok (e.tag () == wjson::VALUE_ARRAY && e.array ().size () == 1,
+        "setter resolves existing path");
+}
+
+void
+test_held (test::simple& ts)
+{
+    wjson::value_type v = wjson::array ();
+    v.push_back (wjson::fixnum (0));
+    wjson::setter_type s = v[0];
+    for (int i = 0; i < 100; ++i)
+        v.push_back (wjson::fixnum (i));
+    s = wjson::fixnum (42);
+    ts.ok (v.get (0).fixnum () == 42 && s.fixnum () == 42,
+        "setter held over array growth");
+    wjson::value_type doc = wjson::table ();
+    doc[L"k"][L"x"] = wjson::fixnum (1);
+    wjson::setter_type x = doc[L"k"][L"x"];
+    for (int i = 0; i < 100; ++i)
+        doc[L"k"][wjson::string_type (L"k") + std::to_wstring (i).c_str ()]
+            = wjson::fixnum (i);
+    doc.get (L"k").table ().erase (wjson::key_type (L"x"));
+    ts.ok (! x.exists () && doc.get (L"k").size () == 100, "setter held over erase");
+    x = wjson::fixnum (7);
+    ts.ok (doc[L"k"][L"x"].fixnum () == 7, "setter held over table growth and erase");
+    x.fixnum ();
+    doc.get (L"k").set (L"x", wjson::fixnum (8));
+    ts.ok (x.fixnum () == 8, "setter reads again after a write");
+}
+
+void
+test_read (test::simple& ts)
+{
+    wjson::value_type doc = wjson::table ();
+    doc.set (L"p", wjson::fixnums ({1, 2, 3}));
+    wjson::setter_type p = doc[L"p"][1];
+    ts.ok (p.exists () && p.tag () == wjson::VALUE_FIXNUM && p.fixnum () == 2
+        && ! doc[L"p"][3].exists (), "setter reads packed element");
+    ts.ok (doc.get (L"p").packed () == wjson::PACK_FIXNUM,
+        "setter read keeps array packed");
+    p = wjson::fixnum (5);
+    ts.ok (doc.get (L"p").get (1).fixnum () == 5, "setter writes packed element");
+    wjson::intern_pool_type pool;
+    {
+        wjson::intern_scope keys (pool);
+        doc[L"n"] = wjson::fixnum (1);
+    }
+    ts.ok (pool.size () == 1 && doc.table ().find (wjson::key_type (L"n"))
+        ->first.interned_with (pool.intern (L"n")), "setter interns new keys");
+}
+
 int
 main ()
 {
-    test::simple ts (32);
+    test::simple ts (44);
 
     wjson_setter_test (ts);
     fruit_test (ts);
+    test_resolved (ts);
+    test_held (ts);
+    test_read (ts);
 
     return ts.done_testing ();
 }
@@ -7,16 +7,75 @@
 
 namespace wjson {
 
+// the child of node for a segment to read, or nullptr when it is missing.
+// an element of a packed array is not a node, and meets a type mismatch.
+static value_type const*
+child (value_type const* const node, setter_segment_type const& seg)
+{
+    if (VALUE_ARRAY == seg.mtag && VALUE_ARRAY == node->tag ()) {
+        if (node->packed () != PACK_NONE && seg.midx < node->size ())
+            throw std::out_of_range ("setter_type::lookup (): packed element");
+        return node->find (seg.midx);
+    }
+    else if (VALUE_TABLE == seg.mtag && VALUE_TABLE == node->tag ()) {
+        table_value_type const& table = node->table ();
+        auto const i = table.find (seg.mkey);
+        return i == table.end () ? nullptr : &i->second;
+    }
+    throw std::out_of_range ("setter_type::lookup (): type mismatch");
+}
+
+// the child of node for a segment to write, or nullptr when it is missing.
+static value_type*
+child (value_type* const node, setter_segment_type const& seg)
+{
+    if (VALUE_ARRAY == seg.mtag && VALUE_ARRAY == node->tag ())
+        return node->find (seg.midx);
+    else if (VALUE_TABLE == seg.mtag && VALUE_TABLE == node->tag ()) {
+        table_value_type& table = node->table ();
+        auto const i = table.find (seg.mkey);
+        return i == table.end () ? nullptr : &i->second;
+    }
+    throw std::out_of_range ("setter_type::lookup (): type mismatch");
+}
+
+// the key of a table segment, from the pool of the current intern_scope.
+static key_type
+segment_key (string_type const& k)
+{
+    intern_pool_type* const pool = current_pool ();
+    return pool != nullptr ? pool->intern (k) : key_type (k);
+}
+
+static key_type
+no_key ()
+{
+    return key_type::view (nullptr, 0);
+}
+
+setter_segment_type::setter_segment_type ()
+    : mtag (VALUE_NULL), midx (0), mkey (no_key ())
+{
+}
+
+setter_segment_type::setter_segment_type (variation const tag,
+    std::size_t const idx, key_type const& key)
+    : mtag (tag), midx (idx), mkey (key)
+{
+}
+
 setter_type::setter_type (value_type& value, std::size_t idx)
-    : mvalue (value), mpath ()
+    : mvalue (value), msize (0), minline (), mspill (), mparent (nullptr),
+      mepoch (0)
 {
-    mpath.push_back ({VALUE_ARRAY, idx, L""});
+    push (VALUE_ARRAY, idx, no_key ());
 }
 
-setter_type::setter_type (value_type& value, std::wstring const& k)
-    : mvalue (value), mpath ()
+setter_type::setter_type (value_type& value, string_type const& k)
+    : mvalue (value), msize (0), minline (), mspill (), mparent (nullptr),
+      mepoch (0)
 {
-    mpath.push_back ({VALUE_TABLE, 0, k});
+    push (VALUE_TABLE, 0, segment_key (k));
 }
 
 setter_type&
@@ -24,228 +83,262 @@ setter_type::operator[] (value_type const& k)
 {
     if (k.tag () != VALUE_STRING)
         throw std::out_of_range ("setter::[](value): string only");
-    mpath.push_back ({VALUE_TABLE, 0, k.string ()});
+    push (VALUE_TABLE, 0, segment_key (k.string ()));
     return *this;
 }
 
 setter_type&
 setter_type::operator[] (std::size_t idx)
 {
-    mpath.push_back ({VALUE_ARRAY, idx, L""});
+    push (VALUE_ARRAY, idx, no_key ());
     return *this;
 }
 
 setter_type&
-setter_type::operator[] (std::wstring const& k)
+setter_type::operator[] (string_type const& k)
 {
-    mpath.push_back ({VALUE_TABLE, 0, k});
+    push (VALUE_TABLE, 0, segment_key (k));
     return *this;
 }
 
 setter_type&
 setter_type::operator= (value_type const& x)
 {
-    value_type* node = force ();
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        node->set (mpath.back ().midx, x);
-    else if (VALUE_TABLE == mpath.back ().mtag)
-        node->set (mpath.back ().mkey, x);
+    store (value_type (x));
     return *this;
 }
 
 setter_type&
 setter_type::operator= (value_type&& x)
 {
-    value_type* node = force ();
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        node->set (mpath.back ().midx, std::move (x));
-    else if (VALUE_TABLE == mpath.back ().mtag)
-        node->set (mpath.back ().mkey, std::move (x));
+    store (std::move (x));
     return *this;
 }
 
 setter_type&
-setter_type::operator= (std::wstring const& x)
+setter_type::operator= (string_type const& x)
 {
-    value_type* node = force ();
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        node->set (mpath.back ().midx, ::wjson::string (x));
-    else if (VALUE_TABLE == mpath.back ().mtag)
-        node->set (mpath.back ().mkey, ::wjson::string (x));
+    store (::wjson::string (x));
     return *this;
 }
 
 setter_type&
-setter_type::operator= (std::wstring&& x)
+setter_type::operator= (string_type&& x)
 {
-    value_type* node = force ();
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        node->set (mpath.back ().midx, ::wjson::string (std::move (x)));
-    else if (VALUE_TABLE == mpath.back ().mtag)
-        node->set (mpath.back ().mkey, ::wjson::string (std::move (x)));
+    store (::wjson::string (std::move (x)));
     return *this;
 }
 
 variation
 setter_type::tag () const
 {
-    value_type* node = lookup ();
-    if (node == nullptr || ! exists ())
+    static const variation TAG[] = {
+        VALUE_ARRAY, VALUE_BOOLEAN, VALUE_FIXNUM, VALUE_FLONUM,
+    };
+    value_type const* const node = parent ();
+    if (node == nullptr)
         return VALUE_NULL;
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).tag ();
-    else
-        return node->get (mpath.back ().mkey).tag ();
+    setter_segment_type const& seg = segment (msize - 1);
+    if (VALUE_ARRAY == seg.mtag && node->packed () != PACK_NONE)
+        return seg.midx < node->size () ? TAG[node->packed ()] : VALUE_NULL;
+    value_type const* const x = child (node, seg);
+    return x == nullptr ? VALUE_NULL : x->tag ();
 }
 
+// vector<bool> has no references to its elements.
 bool const&
 setter_type::boolean () const
 {
-    value_type* node = lookup ();
+    static const bool BOOLEANS[2] = {false, true};
+    if (value_type const* const array = packed_target (PACK_BOOLEAN))
+        return BOOLEANS[array->booleans ()[segment (msize - 1).midx] ? 1 : 0];
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::boolean(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).boolean ();
-    else
-        return node->get (mpath.back ().mkey).boolean ();
+    return node->boolean ();
 }
 
 int64_t const&
 setter_type::fixnum () const
 {
-    value_type* node = lookup ();
+    if (value_type const* const array = packed_target (PACK_FIXNUM))
+        return array->fixnums ()[segment (msize - 1).midx];
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::fixnum(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).fixnum ();
-    else
-        return node->get (mpath.back ().mkey).fixnum ();
+    return node->fixnum ();
 }
 
 double const&
 setter_type::flonum () const
 {
-    value_type* node = lookup ();
+    if (value_type const* const array = packed_target (PACK_FLONUM))
+        return array->flonums ()[segment (msize - 1).midx];
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::flonum(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).flonum ();
-    else
-        return node->get (mpath.back ().mkey).flonum ();
+    return node->flonum ();
 }
 
-std::wstring const&
+datetime_type const&
 setter_type::datetime () const
 {
-    value_type* node = lookup ();
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::datetime(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).datetime ();
-    else
-        return node->get (mpath.back ().mkey).datetime ();
+    return node->datetime ();
 }
 
-std::wstring const&
+string_type const&
 setter_type::string () const
 {
-    value_type* node = lookup ();
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::string(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).string ();
-    else
-        return node->get (mpath.back ().mkey).string ();
+    return node->string ();
 }
 
 array_value_type const&
 setter_type::array () const
 {
-    value_type* node = lookup ();
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::array(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).array ();
-    else
-        return node->get (mpath.back ().mkey).array ();
+    return node->array ();
 }
 
 table_value_type const&
 setter_type::table () const
 {
-    value_type* node = lookup ();
+    value_type const* const node = target ();
     if (node == nullptr)
         throw std::out_of_range ("const setter_type::table(x): not exists");
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->get (mpath.back ().midx).table ();
-    else
-        return node->get (mpath.back ().mkey).table ();
+    return node->table ();
 }
 
+// segments live in the inline buffer, and spill to the vector
+// for deeper paths.
+void
+setter_type::push (variation const tag, std::size_t const idx,
+    key_type const& k)
+{
+    if (msize >= INLINE_SEGMENTS)
+        mspill.emplace_back (tag, idx, k);
+    else {
+        minline[msize].mtag = tag;
+        minline[msize].midx = idx;
+        minline[msize].mkey = k;
+    }
+    ++msize;
+    mparent = nullptr;
+}
+
+setter_segment_type&
+setter_type::segment (std::size_t const i)
+{
+    return i < INLINE_SEGMENTS ? minline[i] : mspill[i - INLINE_SEGMENTS];
+}
+
+setter_segment_type const&
+setter_type::segment (std::size_t const i) const
+{
+    return i < INLINE_SEGMENTS ? minline[i] : mspill[i - INLINE_SEGMENTS];
+}
+
+// the parent of the node of the whole path to read, or nullptr.
+// it is kept while no value is written, and walked again after.
+value_type const*
+setter_type::parent () const
+{
+    std::size_t const epoch = watch_writes ();
+    if (mparent != nullptr && mepoch == epoch)
+        return mparent;
+    value_type const* node = &mvalue;
+    for (std::size_t i = 0; node != nullptr && i + 1 < msize; ++i)
+        node = child (node, segment (i));
+    mparent = node;
+    mepoch = epoch;
+    return node;
+}
+
+// the node of the whole path to read, or nullptr when it does not exist.
+value_type const*
+setter_type::target () const
+{
+    value_type const* const node = parent ();
+    return node == nullptr ? nullptr : child (node, segment (msize - 1));
+}
+
+// the packed array of the given form holding the element of the path,
+// or nullptr.
+value_type const*
+setter_type::packed_target (packing const pack) const
+{
+    value_type const* const node = parent ();
+    setter_segment_type const& seg = segment (msize - 1);
+    if (node != nullptr && VALUE_ARRAY == seg.mtag && node->packed () == pack
+            && seg.midx < node->size ())
+        return node;
+    return nullptr;
+}
+
+// make the missing containers but the last segment, and return its parent.
 value_type*
 setter_type::force ()
 {
     value_type* node = &mvalue;
-    for (std::size_t i = 0; i + 1 < mpath.size (); ++i) {
-        if (VALUE_ARRAY == mpath.at (i).mtag && VALUE_ARRAY == node->tag ()) {
-            if (mpath.at (i).midx >= node->array ().size ()) {
-                if (VALUE_ARRAY == mpath. at(i + 1).mtag)
-                    node->set (mpath.at (i).midx, wjson::array ());
-                else
-                    node->set (mpath.at (i).midx, wjson::table ());
-            }
-            value_type& e = node->array ().at (mpath.at (i).midx);
-            node = &e;
-        }
-        else if (VALUE_TABLE == mpath.at (i).mtag && VALUE_TABLE == node->tag ()) {
-            if (node->table ().count (mpath.at (i).mkey) == 0) {
-                if (VALUE_ARRAY == mpath.at (i + 1).mtag)
-                    node->set (mpath.at (i).mkey, wjson::array ());
-                else
-                    node->set (mpath.at (i).mkey, wjson::table ());                
-            }
-            value_type& e = node->table ().at (mpath.at (i).mkey);
-            node = &e;
+    for (std::size_t i = 0; i + 1 < msize; ++i) {
+        setter_segment_type const& seg = segment (i);
+        value_type* e = child (node, seg);
+        if (e == nullptr) {
+            value_type x = VALUE_ARRAY == segment (i + 1).mtag
+                ? wjson::array () : wjson::table ();
+            if (VALUE_ARRAY == seg.mtag)
+                e = node->set (seg.midx, std::move (x)).find (seg.midx);
+            else
+                e = &node->table ().insert (
+                    std::make_pair (seg.mkey, std::move (x))).first->second;
         }
-        else
-            throw std::out_of_range ("setter_type::force (): type mismatch");
+        node = e;
     }
     return node;
 }
 
+void
+setter_type::store (value_type&& x)
+{
+    value_type* const parent = force ();
+    setter_segment_type const& seg = segment (msize - 1);
+    value_type* const node = child (parent, seg);
+    if (node != nullptr)
+        *node = std::move (x);
+    else if (VALUE_ARRAY == seg.mtag)
+        parent->set (seg.midx, std::move (x));
+    else
+        parent->table ().insert (std::make_pair (seg.mkey, std::move (x)));
+}
+
+// the parent of the node of the whole path, or nullptr. it walks
+// by the non-const accessors, which unshare and unpack the path.
 value_type*
 setter_type::lookup () const
 {
     value_type* node = &mvalue;
-    for (std::size_t i = 0; i + 1 < mpath.size (); ++i) {
-        if (VALUE_ARRAY == mpath.at (i).mtag && VALUE_ARRAY == node->tag ()) {
-            if (mpath.at (i).midx >= node->array ().size ())
-                return nullptr;
-            value_type& e = node->array ().at (mpath.at (i).midx);
-            node = &e;
-        }
-        else if (VALUE_TABLE == mpath.at (i).mtag && VALUE_TABLE == node->tag ()) {
-            if (node->table ().count (mpath.at (i).mkey) == 0)
-                return nullptr;
-            value_type& e = node->table ().at (mpath.at (i).mkey);
-            node = &e;
-        }
-        else
-            throw std::out_of_range ("setter_type::force (): type mismatch");
-    }
+    for (std::size_t i = 0; node != nullptr && i + 1 < msize; ++i)
+        node = child (node, segment (i));
     return node;
 }
 
 bool
 setter_type::exists () const
 {
-    value_type* node = lookup ();
+    value_type const* const node = parent ();
     if (node == nullptr)
         return false;
-    if (VALUE_ARRAY == mpath.back ().mtag)
-        return node->exists (mpath.back ().midx);
-    else
-        return node->exists (mpath.back ().mkey);
+    setter_segment_type const& seg = segment (msize - 1);
+    if (VALUE_ARRAY == seg.mtag && node->packed () != PACK_NONE)
+        return seg.midx < node->size ();
+    return child (node, seg) != nullptr;
 }
 
 bool
@@ -256,8 +349,9 @@ exists (setter_type const& setter)
 
 }//namespace wjson
 
-std::wostream&
-operator<< (std::wostream& out, wjson::setter_type const& setter)
+std::basic_ostream<wjson::char_type>&
+operator<< (std::basic_ostream<wjson::char_type>& out,
+    wjson::setter_type const& setter)
 {
     out << setter.string ();
     return out;
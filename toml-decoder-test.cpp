@@ -229,18 +229,24 @@ date6 = 1979-05-27
     wjson::value_type got;
     ts.ok (wjson::decode_toml (input, got), "toml decode datetime");
     ts.ok (got.size () == 6, "toml decode datetime size 6");
-    ts.ok (got[L"date1"].datetime () == L"1979-05-27T07:32:00Z",
+    ts.ok (wjson::encode_datetime (got[L"date1"].datetime ()) == "1979-05-27T07:32:00Z",
         "toml decode datetime date1");
-    ts.ok (got[L"date2"].datetime () == L"1979-05-27T00:32:00-07:00",
+    ts.ok (wjson::encode_datetime (got[L"date2"].datetime ()) == "1979-05-27T00:32:00-07:00",
         "toml decode datetime date2");
-    ts.ok (got[L"date3"].datetime () == L"1979-05-27T00:32:00.999999-07:00",
+    ts.ok (wjson::encode_datetime (got[L"date3"].datetime ()) == "1979-05-27T00:32:00.999999-07:00",
         "toml decode datetime date3");
-    ts.ok (got[L"date4"].datetime () == L"1979-05-27T07:32:00",
+    ts.ok (wjson::encode_datetime (got[L"date4"].datetime ()) == "1979-05-27T07:32:00",
         "toml decode datetime date4");
-    ts.ok (got[L"date5"].datetime () == L"1979-05-27T00:32:00.999999",
+    ts.ok (wjson::encode_datetime (got[L"date5"].datetime ()) == "1979-05-27T00:32:00.999999",
         "toml decode datetime date5");
-    ts.ok (got[L"date6"].datetime () == L"1979-05-27",
+    ts.ok (wjson::encode_datetime (got[L"date6"].datetime ()) == "1979-05-27",
         "toml decode datetime date6");
+    ts.ok (wjson::same_instant (got[L"date1"].datetime (), got[L"date2"].datetime ())
+        && got[L"date1"].datetime () != got[L"date2"].datetime ()
+        && got[L"date2"].datetime () < got[L"date3"].datetime (),
+        "toml decode datetime compare");
+    std::string bad ("date = 1979-02-29T07:32:00Z\n");
+    ts.ok (! wjson::decode_toml (bad, got), "toml decode datetime invalid");
 }
 
 void
@@ -325,6 +331,46 @@ arr8 = [
     ts.ok (got[L"arr8"][1].fixnum () == 2, "toml decode array_5 [arr8][1]");
 }
 
+void
+test_array_packed (test::simple& ts)
+{
+    std::string input (
+R"q(ints = [ 1, 2, 3 ]
+floats = [ 0.5, 1.5 ]
+nest = [ [ true, false ], [ 4 ] ]
+)q");
+    wjson::value_type got;
+    ts.ok (wjson::decode_toml (input, got, wjson::DECODE_PACK_ARRAY),
+        "toml decode array packed");
+    wjson::value_type const& x = got;
+    ts.ok (x.get (L"ints").fixnums ().size () == 3
+        && x.get (L"ints").fixnums ()[2] == 3, "toml decode array packed fixnums");
+    ts.ok (x.get (L"floats").flonums ()[1] == 1.5, "toml decode array packed flonums");
+    ts.ok (x.get (L"nest").packed () == wjson::PACK_NONE
+        && x.get (L"nest").get (0).booleans ()[0]
+        && x.get (L"nest").get (1).fixnums ()[0] == 4, "toml decode array packed nest");
+}
+
+void
+test_lazy_number (test::simple& ts)
+{
+    std::string input (
+R"q(id = 1_234_567_890_123_456_789_012
+port = +8080
+ratio = 6.25e-1
+)q");
+    wjson::value_type got;
+    ts.ok (wjson::decode_toml (input, got, wjson::DECODE_LAZY_NUMBER),
+        "toml decode lazy number");
+    wjson::value_type const& x = got;
+    ts.ok (x.get (L"id").tag () == wjson::VALUE_FIXNUM
+        && *x.get (L"id").literal () == "1234567890123456789012",
+        "toml decode lazy number big fixnum");
+    ts.ok (*x.get (L"port").literal () == "8080" && x.get (L"port").fixnum () == 8080,
+        "toml decode lazy number fixnum");
+    ts.ok (x.get (L"ratio").flonum () == 0.625, "toml decode lazy number flonum");
+}
+
 void
 test_table_1 (test::simple& ts)
 {
@@ -438,6 +484,11 @@ color = "gray"
         "toml decode array_of_table_1 [products][2][sku]");
     ts.ok (got[L"products"][2][L"color"].string () == L"gray",
         "toml decode array_of_table_1 [products][2][color]");
+    wjson::value_type const& products = got.get (L"products");
+    wjson::key_type const name = wjson::key_type::view (L"name", 4);
+    ts.ok (products.get (0).table ().find (name)->first.interned_with (
+        products.get (2).table ().find (name)->first),
+        "toml decode array_of_table_1 interned keys");
 }
 
 void
@@ -483,7 +534,7 @@ R"q([[fruit]]
 
 int main ()
 {
-    test::simple ts (124);
+    test::simple ts (135);
     test_comment (ts);
     test_string_1 (ts);
     test_string_2 (ts);
@@ -500,6 +551,8 @@ int main ()
     test_array_3 (ts);
     test_array_4 (ts);
     test_array_5 (ts);
+    test_array_packed (ts);
+    test_lazy_number (ts);
     test_table_1 (ts);
     test_table_2 (ts);
     test_table_3 (ts);
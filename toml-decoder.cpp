@@ -4,6 +4,8 @@
 #include <deque>
 #include <utility>
 #include "toml.hpp"
+#include "encode-utf8.hpp"
+#include "decode-number.hpp"
 
 namespace wjson {
 
@@ -29,13 +31,14 @@ enum {
 
 class toml_decoder_type {
 public:
-    toml_decoder_type (std::string const& str);
+    toml_decoder_type (std::string const& str, int const flags);
     bool decode (value_type& root);
 private:
+    int const flags;
     int kvstate;
     std::string const& string;
     std::string::const_iterator iter;
-    std::map<std::wstring,int> mark;
+    std::map<string_type,int> mark;
 
     int next_token (value_type& value);
     int scan_key (value_type& value);
@@ -47,16 +50,26 @@ private:
     value_type& merge_table (value_type& x, value_type const& path, value_type const& y);
     value_type& merge_array (value_type& x, value_type const& path, value_type const& y);
     value_type& unify_back (value_type& x, value_type const& y);
-    std::wstring path_to_string (value_type const& path);
+    string_type path_to_string (value_type const& path);
 };
 
 bool
-decode_toml (std::string const& str, value_type& root)
+decode_toml (std::string const& str, value_type& root, int const flags)
 {
-    toml_decoder_type decoder (str);
+    intern_pool_type pool;
+    intern_scope keys (current_pool () ? *current_pool () : pool);
+    toml_decoder_type decoder (str, flags);
     return decoder.decode (root);
 }
 
+bool
+decode_toml (std::string const& str, document_type& doc, int const flags)
+{
+    arena_scope scope (doc.arena ());
+    intern_scope keys (doc.pool ());
+    return decode_toml (str, doc.root (), flags);
+}
+
 static inline int
 lookup_cls (uint32_t const tbl[], std::size_t const n, uint32_t const octet)
 {
@@ -80,8 +93,8 @@ hex (uint32_t const octet)
           : 0;
 }
 
-toml_decoder_type::toml_decoder_type (std::string const& str)
-    : kvstate (0), string (str), iter (str.cbegin ()), mark ()
+toml_decoder_type::toml_decoder_type (std::string const& str, int const flags)
+    : flags (flags), kvstate (0), string (str), iter (str.cbegin ()), mark ()
 {
 }
 
@@ -187,6 +200,9 @@ toml_decoder_type::decode (value_type& root)
             case 1: // toml: statements sections
                 value = merge_exclusive (v[1], v[2]);
                 break;
+            case 4: // toml:
+                value = ::wjson::table ();
+                break;
             case 5: // sections: sections "[" keypath "]" ENDLINE statements
                 value = merge_table (v[1], v[3], v[6]);
                 break;
@@ -226,6 +242,8 @@ toml_decoder_type::decode (value_type& root)
                 break;
             case 25: // value: "[" array "]"
                 std::swap (value, v[2]);
+                if (flags & DECODE_PACK_ARRAY)
+                    value.pack ();
                 break;
             case 26: // value: "{" table "}"
                 kvstate = 2;
@@ -237,6 +255,8 @@ toml_decoder_type::decode (value_type& root)
             case 31: // value_list: value_list "," endln value endln
                 value = unify_back (v[1], v[4]);
                 break;
+            case 32: // endln:
+                break;
             case 34: // table:
                 value = ::wjson::table ();
                 break;
@@ -297,7 +317,7 @@ toml_decoder_type::scan_key (value_type& value)
     };
     static const uint32_t MATCH = 14U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    string_type literal;
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
@@ -370,7 +390,7 @@ toml_decoder_type::scan_value (value_type& value)
     };
     static const uint32_t MATCH = 16U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    std::string literal;
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
@@ -410,9 +430,9 @@ toml_decoder_type::scan_value (value_type& value)
             literal.push_back (octet);
     }
     if (kind == TOKEN_BOOLEAN) {
-        if (literal == L"true")
+        if (literal == "true")
             value = ::wjson::boolean (true);
-        else if (literal == L"false")
+        else if (literal == "false")
             value = ::wjson::boolean (false);
     }
     if (kind == TOKEN_INVALID && s == e) {
@@ -478,7 +498,7 @@ toml_decoder_type::scan_string (value_type& value)
     };
     static const uint32_t MATCH = 14U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    string_type literal;
     uint32_t uc = 0;
     int mbyte = 1;
     std::string::const_iterator s = iter;
@@ -517,7 +537,7 @@ toml_decoder_type::scan_string (value_type& value)
                 return TOKEN_INVALID;
             if (0xd800L <= uc && uc <= 0xdfffL)
                 return TOKEN_INVALID;
-            literal.push_back (uc);
+            append_code (literal, uc);
             uc = 0;
             break;
         case 3:
@@ -546,7 +566,7 @@ toml_decoder_type::scan_string (value_type& value)
             uc = (uc << 4) + hex (octet);
             if ((0xd800L <= uc && uc <= 0xdfffL) || UPPERBOUND < uc)
                 return TOKEN_INVALID;
-            literal.push_back (uc);
+            append_code (literal, uc);
             uc = 0;
             break;
         default:
@@ -587,7 +607,8 @@ toml_decoder_type::scan_number (value_type& value)
     };
     static const uint32_t MATCH = 10U;
     int kind = TOKEN_INVALID;
-    std::wstring literal;
+    std::string literal;
+    std::size_t accepted = 0;
     std::string::const_iterator s = iter;
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
@@ -599,38 +620,44 @@ toml_decoder_type::scan_number (value_type& value)
         int m = BASE[prev_state] + MATCH;
         if (0 < j && j < NSHIFT && (SHIFT[j] & 0xff) == prev_state)
             next_state = (SHIFT[j] >> 8) & 0xff;
-        if (next_state && s < e && '_' != octet)
-            literal.push_back (octet);
         if (0 < m && m < NSHIFT && (SHIFT[m] & 0xff) == prev_state) {
             kind = (SHIFT[m] >> 8) & 0xff;
-            try {
-                if (TOKEN_FIXNUM == kind)
-                    value = ::wjson::fixnum (std::stoll (literal));
-                else if (TOKEN_FLONUM == kind)
-                    value = ::wjson::flonum (std::stod (literal));
-                else
-                    value = ::wjson::datetime (literal);
-            }
-            catch (std::out_of_range) {
-                value = ::wjson::null ();
-                return TOKEN_INVALID;
-            }
+            accepted = literal.size ();
             iter = s;
         }
+        if (next_state && s < e && '_' != octet)
+            literal.push_back (octet);
         if (! next_state)
             break;
     }
+    if (TOKEN_INVALID == kind)
+        return kind;
+    literal.resize (accepted);
+    int64_t fixnum;
+    double flonum;
+    datetime_type t;
+    if ((flags & DECODE_LAZY_NUMBER) && TOKEN_DATETIME != kind)
+        value = ::wjson::number_literal (
+            literal[0] == '+' ? literal.substr (1) : literal);
+    else if (TOKEN_FIXNUM == kind && decode_fixnum (literal, fixnum))
+        value = ::wjson::fixnum (fixnum);
+    else if (TOKEN_FLONUM == kind && decode_flonum (literal, flonum))
+        value = ::wjson::flonum (flonum);
+    else if (TOKEN_DATETIME == kind && decode_datetime (literal, t))
+        value = ::wjson::datetime (t);
+    else {
+        value = ::wjson::null ();
+        return TOKEN_INVALID;
+    }
     return kind;
 }
 
 value_type&
 toml_decoder_type::merge_exclusive (value_type& x, value_type const& y)
 {
-    for (auto& i : y.table ()) {
-        if (x.table ().count (i.first) > 0)
+    for (auto& i : y.table ())
+        if (! x.table ().insert (i).second)
             throw std::out_of_range ("merge_exclusive: conflict table");
-        x.set (i.first, i.second);
-    }
     return x;
 }
 
@@ -638,7 +665,7 @@ value_type&
 toml_decoder_type::merge_table (value_type& x, value_type const& path, value_type const& y)
 {
     if (path.size () > 0) {
-        std::wstring pathstr = path_to_string (path);
+        string_type pathstr = path_to_string (path);
         if (mark.count (pathstr) > 0)
             throw std::out_of_range ("merge_table: path once");
         mark[pathstr] = 1;
@@ -650,8 +677,8 @@ toml_decoder_type::merge_table (value_type& x, value_type const& path, value_typ
         else if (node->tag () != VALUE_TABLE)
             throw std::out_of_range ("merge_table: conflict table");
         else if (i < path.size ()) {
-            std::wstring key = path.get (i).string ();
-            if (node->table ().count (key) == 0)
+            string_type key = path.get (i).string ();
+            if (node->table ().count (key_type::view (key)) == 0)
                 node->set (key, ::wjson::table ());
             node = &(node->get (key));
             ++i;
@@ -668,7 +695,7 @@ value_type&
 toml_decoder_type::merge_array (value_type& x, value_type const& path, value_type const& y)
 {
     if (path.size () > 0) {
-        std::wstring pathstr = path_to_string (path);
+        string_type pathstr = path_to_string (path);
         if (mark.count (pathstr) > 0 && mark.at (pathstr) == 1)
             throw std::out_of_range ("merge_array: path once");
         mark[pathstr] = 2;
@@ -680,15 +707,15 @@ toml_decoder_type::merge_array (value_type& x, value_type const& path, value_typ
         else if (i + 1 < path.size ()) {
             if (node->tag () != VALUE_TABLE)
                 throw std::out_of_range ("merge_array: conflict table");
-            std::wstring key = path.get (i).string ();
-            if (node->table ().count (key) == 0)
+            string_type key = path.get (i).string ();
+            if (node->table ().count (key_type::view (key)) == 0)
                 node->set (key, ::wjson::table ());
             node = &(node->get (key));
             ++i;
         }
         else {
-            std::wstring key = path.get (i).string ();
-            if (node->table ().count (key) == 0)
+            string_type key = path.get (i).string ();
+            if (node->table ().count (key_type::view (key)) == 0)
                 node->set (key, ::wjson::array ());
             node = &(node->get (key));
             if (node->tag () != VALUE_ARRAY)
@@ -710,16 +737,16 @@ toml_decoder_type::unify_back (value_type& x, value_type const& y)
     return x;
 }
 
-std::wstring
+string_type
 toml_decoder_type::path_to_string (value_type const& path)
 {
-    std::wstring t;
+    string_type t;
     for (auto& k : path.array ()) {
-        t.push_back (L'.');
-        for (wchar_t c : k.string ())
+        t.push_back ('.');
+        for (char_type c : k.string ())
             switch (c) {
-            case L'.': t += L"\\."; break;
-            case L'\\': t += L"\\\\"; break;
+            case '.': t.push_back ('\\'); t.push_back ('.'); break;
+            case '\\': t.push_back ('\\'); t.push_back ('\\'); break;
             default: t.push_back (c); break;
             }
     }
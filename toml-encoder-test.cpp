@@ -90,7 +90,7 @@ test_datetime (test::simple& ts)
 void
 test_string (test::simple& ts)
 {
-    std::wstring ascii;
+    wjson::string_type ascii;
     for (int c = 0; c < 128; ++c)
         ascii.push_back (c);
 
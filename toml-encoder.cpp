@@ -10,22 +10,24 @@
 namespace wjson {
 
 static void encode_section (std::ostream& out, value_type const& value,
-    std::vector<std::wstring>& path);
+    std::vector<string_type>& path);
 static void encode_path (std::ostream& out,
-    char const* lft, std::vector<std::wstring>& path, char const* rgt);
+    char const* lft, std::vector<string_type>& path, char const* rgt);
 static void encode_table (std::ostream& out,
-    value_type const& value, std::vector<std::wstring>& path);
-static void encode_key (std::ostream& out, std::wstring const& key);
+    value_type const& value, std::vector<string_type>& path);
+static void encode_key (std::ostream& out, string_type const& key);
 static void encode_flow (std::ostream& out, value_type const& value);
+static void encode_element (std::ostream& out, value_type const& value,
+    std::size_t const i);
 static void encode_flonum (std::ostream& out, double const x);
-static void encode_string (std::ostream& out, std::wstring const& str);
-static void encode_bare (std::ostream& out, std::wstring const& str);
+static void encode_string (std::ostream& out, string_type const& str);
+static void encode_bare (std::ostream& out, string_type const& str);
 
 std::string
 encode_toml (value_type const& root)
 {
     std::ostringstream got;
-    std::vector<std::wstring> path;
+    std::vector<string_type> path;
     encode_section (got, root, path);
     return got.str ();
 }
@@ -33,13 +35,13 @@ encode_toml (value_type const& root)
 void
 encode_toml (std::ostream& out, value_type const& root)
 {
-    std::vector<std::wstring> path;
+    std::vector<string_type> path;
     encode_section (out, root, path);
 }
 
 static void
 encode_section (std::ostream& out, value_type const& value,
-    std::vector<std::wstring>& path)
+    std::vector<string_type>& path)
 {
     if (value.tag () == VALUE_TABLE) {
         encode_path (out, "\n[", path, "]\n");
@@ -55,7 +57,7 @@ encode_section (std::ostream& out, value_type const& value,
 
 static void
 encode_path (std::ostream& out,
-    char const* lft, std::vector<std::wstring>& path, char const* rgt)
+    char const* lft, std::vector<string_type>& path, char const* rgt)
 {
     if (path.empty ())
         return;
@@ -70,30 +72,32 @@ encode_path (std::ostream& out,
 
 static void
 encode_table (std::ostream& out,
-    value_type const& value, std::vector<std::wstring>& path)
+    value_type const& value, std::vector<string_type>& path)
 {
-    for (auto x : value.table ()) {
-        if (x.second.tag () != VALUE_TABLE && x.second.tag () != VALUE_ARRAY) {
-            encode_key (out, x.first);
+    table_entries_type const entries = sorted_entries (value.table ());
+    for (auto x : entries) {
+        if (x->second.tag () != VALUE_TABLE && x->second.tag () != VALUE_ARRAY) {
+            encode_key (out, x->first);
             out << "=";
-            encode_flow (out, x.second);
+            encode_flow (out, x->second);
             out << std::endl;
         }
     }
-    for (auto x : value.table ()) {
-        path.push_back (x.first);
-        if (x.second.tag () == VALUE_TABLE) {
-            encode_section (out, x.second, path);
+    for (auto x : entries) {
+        path.push_back (x->first);
+        if (x->second.tag () == VALUE_TABLE) {
+            encode_section (out, x->second, path);
         }
-        else if (x.second.tag () == VALUE_ARRAY
-                && x.second.size () > 0
-                && x.second.get (0).tag () == VALUE_TABLE) {
-            encode_section (out, x.second, path);
+        else if (x->second.tag () == VALUE_ARRAY
+                && x->second.size () > 0
+                && x->second.packed () == PACK_NONE
+                && x->second.get (0).tag () == VALUE_TABLE) {
+            encode_section (out, x->second, path);
         }
-        else if (x.second.tag () == VALUE_ARRAY) {
-            encode_key (out, x.first);
+        else if (x->second.tag () == VALUE_ARRAY) {
+            encode_key (out, x->first);
             out << "=";
-            encode_flow (out, x.second);
+            encode_flow (out, x->second);
             out << std::endl;            
         }
         path.pop_back ();
@@ -101,7 +105,7 @@ encode_table (std::ostream& out,
 }
 
 static void
-encode_key (std::ostream& out, std::wstring const& key)
+encode_key (std::ostream& out, string_type const& key)
 {
     bool barekey = true;
     for (int c : key) {
@@ -119,7 +123,7 @@ encode_key (std::ostream& out, std::wstring const& key)
 }
 
 static void
-encode_bare (std::ostream& out, std::wstring const& key)
+encode_bare (std::ostream& out, string_type const& key)
 {
     for (int c : key)
         out.put (c);
@@ -136,27 +140,37 @@ encode_flow (std::ostream& out, value_type const& value)
         else
             out << "false";
         break;
-    case VALUE_FIXNUM: out << value.fixnum (); break;
-    case VALUE_FLONUM: encode_flonum (out, value.flonum ()); break;
-    case VALUE_DATETIME: encode_bare (out, value.datetime ()); break;
+    case VALUE_FIXNUM:
+    case VALUE_FLONUM:
+        if (value.literal () != nullptr)
+            out << *value.literal ();
+        else if (value.tag () == VALUE_FIXNUM)
+            out << value.fixnum ();
+        else
+            encode_flonum (out, value.flonum ());
+        break;
+    case VALUE_DATETIME: out << encode_datetime (value.datetime ()); break;
     case VALUE_STRING: encode_string (out, value.string ()); break;
     case VALUE_TABLE:
         out << "{";
-        for (auto x : value.table ()) {
+        for (auto x : sorted_entries (value.table ())) {
             if (c++ > 0)
                 out << ",";
-            encode_key (out, x.first);
+            encode_key (out, x->first);
             out << "=";
-            encode_flow (out, x.second);
+            encode_flow (out, x->second);
         }
         out << "}";
         break;
     case VALUE_ARRAY:
         out << "[";
-        for (auto x : value.array ()) {
-            if (c++ > 0)
+        for (std::size_t i = 0; i < value.size (); ++i) {
+            if (i > 0)
                 out << ",";
-            encode_flow (out, x);
+            if (value.packed () == PACK_NONE)
+                encode_flow (out, value.array ()[i]);
+            else
+                encode_element (out, value, i);
         }
         out << "]";
         break;
@@ -165,6 +179,20 @@ encode_flow (std::ostream& out, value_type const& value)
     }
 }
 
+// an element of packed array.
+static void
+encode_element (std::ostream& out, value_type const& value, std::size_t const i)
+{
+    switch (value.packed ()) {
+    case PACK_BOOLEAN:
+        out << (value.booleans ()[i] ? "true" : "false");
+        break;
+    case PACK_FIXNUM: out << value.fixnums ()[i]; break;
+    case PACK_FLONUM: encode_flonum (out, value.flonums ()[i]); break;
+    default: break;
+    }
+}
+
 static void
 encode_flonum (std::ostream& out, double const x)
 {
@@ -177,10 +205,10 @@ encode_flonum (std::ostream& out, double const x)
 }
 
 static void
-encode_string (std::ostream& out, std::wstring const& str)
+encode_string (std::ostream& out, string_type const& str)
 {
     out.put ('"');
-    for (std::wstring::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
+    for (string_type::const_iterator s = str.cbegin (); s < str.cend (); ++s) {
         uint32_t const uc = static_cast<uint32_t> (*s);
         if (uc < 0x80) {
             switch (uc) {
@@ -206,7 +234,7 @@ encode_string (std::ostream& out, std::wstring const& str)
             }
         }
         else {
-            encode_utf8 (out, uc);
+            encode_utf8 (out, *s);
         }
     }
     out.put ('"');
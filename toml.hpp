@@ -9,7 +9,10 @@
 
 namespace wjson {
 
-bool decode_toml (std::string const& str, value_type& root);
+bool decode_toml (std::string const& str, value_type& root,
+    int const flags = 0);
+bool decode_toml (std::string const& str, document_type& doc,
+    int const flags = 0);
 
 std::string encode_toml (value_type const& root);
 void encode_toml (std::ostream& out, value_type const& root);
@@ -0,0 +1,80 @@
+#include "value.hpp"
+#include "json.hpp"
+#include "toml.hpp"
+#include "yaml.hpp"
+#include "taptests.hpp"
+#include <string>
+#include <type_traits>
+
+// built with -DWJSON_UTF8_STRING, where strings and keys are UTF-8.
+
+void
+test_json (test::simple& ts)
+{
+    ts.ok (std::is_same<wjson::char_type, char>::value, "char_type is char");
+    wjson::value_type v;
+    std::string input (u8R"q({"kéy":"いろは😀","e":"é😀\u0001"})q");
+    ts.ok (wjson::decode_json (input, v), "decode_json");
+    ts.ok (v.get ("e").string () == u8"é😀\x01", "decode_json escapes");
+    ts.ok (v.get ("e").string ().size () == 7, "decode_json octets");
+    ts.ok (wjson::encode_json (v)
+        == u8R"q({"e":"é😀\u0001","kéy":"いろは😀"})q", "encode_json");
+    wjson::value_type w;
+    ts.ok (wjson::decode_json (wjson::encode_json (v), w) && w == v,
+        "encode_json round trip");
+}
+
+void
+test_key (test::simple& ts)
+{
+    wjson::value_type v;
+    wjson::decode_json (u8R"q({"kéy":"いろは😀","ひ":1})q", v);
+    ts.ok (v.get (u8"kéy").string () == u8"いろは😀", "get narrow key");
+    ts.ok (v.exists (u8"ひ") && ! v.exists (u8"ひひ"), "exists narrow key");
+    ts.ok (v.find (u8"ひ", 3) != nullptr, "find narrow key with length");
+    ts.ok (v.find (L"kéy", 3) != nullptr, "find wide key");
+    ts.ok (v.find (L"ひ", 1) != nullptr
+        && v.find (L"ひ", 1)->fixnum () == 1, "find wide key value");
+    ts.ok (v.find (L"び", 1) == nullptr, "find missing wide key");
+    v[u8"ぬ"] = u8"ル";
+    ts.ok (v.get (u8"ぬ").string () == u8"ル", "setter narrow key");
+    ts.ok (v.table ().size () == 3, "table size");
+}
+
+void
+test_toml (test::simple& ts)
+{
+    wjson::value_type v;
+    std::string input (u8"[tbl]\n\"ké.y\" = \"é\\u00e9\"\n\"ひ\" = 'いろは'\n");
+    ts.ok (wjson::decode_toml (input, v), "decode_toml");
+    ts.ok (v.get ("tbl").get (u8"ké.y").string () == u8"éé", "decode_toml escape");
+    ts.ok (v.get ("tbl").get (u8"ひ").string () == u8"いろは",
+        "decode_toml literal string");
+    wjson::value_type w;
+    ts.ok (wjson::decode_toml (wjson::encode_toml (v), w) && w == v,
+        "encode_toml round trip");
+}
+
+void
+test_yaml (test::simple& ts)
+{
+    wjson::value_type v;
+    wjson::decode_yaml (u8"a: ひ\nb: [1, é]\n", v);
+    ts.ok (v.get ("a").string () == u8"ひ", "decode_yaml string");
+    ts.ok (v.get ("b").get (1).string () == u8"é", "decode_yaml flow");
+    ts.ok (wjson::encode_json (v) == u8R"q({"a":"ひ","b":[1,"é"]})q",
+        "decode_yaml encode_json");
+}
+
+int
+main ()
+{
+    test::simple ts (21);
+
+    test_json (ts);
+    test_key (ts);
+    test_toml (ts);
+    test_yaml (ts);
+
+    return ts.done_testing ();
+}
@@ -60,12 +60,235 @@ wjson_value_test (test::simple& ts)
         "table.get(string(bar)) == Bar");
 }
 
+void
+test_compact (test::simple& ts)
+{
+    ts.ok (sizeof (wjson::value_type) <= 16, "value_type 16 bytes");
+    wjson::value_type x = wjson::array ();
+    x.push_back (wjson::table ());
+    x.get (0).set (L"foo", wjson::string (L"Foo"));
+    wjson::value_type y (std::move (x));
+    ts.ok (x.tag () == wjson::VALUE_NULL && y.get (0).get (L"foo").string () == L"Foo",
+        "move leaves null");
+    y = y.get (0);
+    ts.ok (y.tag () == wjson::VALUE_TABLE && y.get (L"foo").string () == L"Foo",
+        "assign from own element");
+    y = std::move (y.get (L"foo"));
+    ts.ok (y.tag () == wjson::VALUE_STRING && y.string () == L"Foo",
+        "move assign from own element");
+}
+
+void
+test_copy_on_write (test::simple& ts)
+{
+    wjson::value_type x = wjson::table ();
+    x.set (L"a", wjson::array ());
+    x.get (L"a").push_back (wjson::fixnum (1)).push_back (wjson::fixnum (2));
+    wjson::value_type y (x);
+    y.get (L"a").push_back (wjson::fixnum (3));
+    wjson::value_type const& cx = x;
+    ts.ok (cx.get (L"a").size () == 2 && y.get (L"a").size () == 3,
+        "write to copy keeps original");
+    wjson::value_type z = y;
+    y.get (L"a").get (0) = wjson::fixnum (10);
+    ts.ok (z.get (L"a").get (0).fixnum () == 1 && y.get (L"a").get (0).fixnum () == 10,
+        "write to element keeps copy");
+    z.get (L"a").array ().clear ();
+    ts.ok (y.get (L"a").size () == 3, "array() unshares");
+}
+
+void
+test_packed (test::simple& ts)
+{
+    wjson::value_type x = wjson::array ();
+    x.push_back (wjson::fixnum (1)).push_back (wjson::fixnum (2));
+    ts.ok (x.pack () && x.packed () == wjson::PACK_FIXNUM, "pack fixnums");
+    ts.ok (x.tag () == wjson::VALUE_ARRAY && x.size () == 2
+        && x.fixnums ()[1] == 2, "packed fixnums");
+    wjson::value_type const& cx = x;
+    bool thrown = false;
+    try {
+        cx.get (0);
+    }
+    catch (std::out_of_range&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "packed get()const throws");
+    wjson::value_type y = x;
+    ts.ok (y.get (1).fixnum () == 2 && y.packed () == wjson::PACK_NONE,
+        "get() unpacks");
+    ts.ok (x.packed () == wjson::PACK_FIXNUM, "copy keeps packed");
+    y.push_back (wjson::flonum (0.5));
+    ts.ok (! y.pack (), "mixed array not packed");
+    wjson::value_type z = wjson::flonums ({0.5, 1.5});
+    ts.ok (z.flonums ().size () == 2 && z.array ()[1].flonum () == 1.5,
+        "flonums array()");
+    int64_t sum = 0;
+    for (auto const& e : cx.elements ())
+        sum += e.fixnum ();
+    ts.ok (cx.elements ().size () == 2 && sum == 3
+        && x.packed () == wjson::PACK_FIXNUM, "elements() reads packed");
+    wjson::value_type const b = wjson::booleans ({true, false});
+    auto i = b.elements ().begin ();
+    ts.ok (i->boolean () && ! (++i)->boolean ()
+        && ++i == b.elements ().end (), "elements() iterator");
+    ts.ok (y.elements ().begin ()->fixnum () == 1
+        && &*y.elements ().begin () == &y.array ()[0], "elements() unpacked");
+}
+
+void
+test_emplace (test::simple& ts)
+{
+    ts.ok (std::is_nothrow_move_constructible<wjson::value_type>::value,
+        "nothrow move");
+    wjson::value_type x = wjson::array ();
+    x.reserve (3);
+    x.emplace_back ().assign_fixnum (1);
+    wjson::value_type& t = x.emplace_back (wjson::table ());
+    t.emplace (L"a").assign_string (L"foo");
+    t.emplace (wjson::string_type (L"b"), wjson::fixnum (2));
+    ts.ok (x.size () == 2 && x.array ().capacity () >= 3
+        && x.get (0).fixnum () == 1, "emplace_back");
+    ts.ok (t.emplace (wjson::string_type (L"b"), wjson::fixnum (3)).fixnum () == 2
+        && t.get (L"a").string () == L"foo", "emplace keeps existing");
+    wjson::value_type y = wjson::string (L"bar");
+    x.get (1).set (wjson::string_type (L"a"), std::move (y));
+    ts.ok (x.get (1).get (L"a").string () == L"bar" && y.tag () == wjson::VALUE_NULL,
+        "set moves");
+}
+
+void
+test_intern (test::simple& ts)
+{
+    wjson::intern_pool_type pool;
+    wjson::key_type a = pool.intern (L"id");
+    wjson::key_type b = pool.intern (wjson::string_type (L"id"));
+    ts.ok (a.interned_with (b) && pool.size () == 1, "intern same key");
+    ts.ok (a == wjson::key_type::view (L"id", 2)
+        && a < wjson::key_type (L"ie") && a.str () == L"id", "key compare");
+    wjson::value_type x = wjson::array ();
+    {
+        wjson::intern_scope scope (pool);
+        x.emplace_back (wjson::table ()).set (L"id", wjson::fixnum (1));
+        x.emplace_back (wjson::table ()).set (L"id", wjson::fixnum (2));
+    }
+    x.emplace_back (wjson::table ()).set (L"id", wjson::fixnum (3));
+    wjson::key_type const& k0 = x.get (0).table ().begin ()->first;
+    wjson::key_type const& k1 = x.get (1).table ().begin ()->first;
+    wjson::key_type const& k2 = x.get (2).table ().begin ()->first;
+    ts.ok (k0.interned_with (k1) && ! k0.interned_with (k2) && k0 == k2,
+        "tables share interned keys in scope");
+}
+
+void
+test_find (test::simple& ts)
+{
+    wjson::value_type x = wjson::table ();
+    x.set (L"n", wjson::fixnum (7));
+    x.set (L"a", wjson::fixnums ({1, 2, 3}));
+    wjson::value_type const& c = x;
+    ts.ok (c.find (L"n") && *c.find (L"n")->if_fixnum () == 7, "find key");
+    ts.ok (! c.find (L"m") && ! c.find (1) && ! c.get (L"n").find (L"n"),
+        "find misses without throwing");
+    ts.ok (! c.get (L"n").if_string () && ! c.get (L"n").if_flonum ()
+        && c.get (L"n").if_fixnum (), "if_ accessors check tags");
+    ts.ok (! c.get (L"a").find (1) && ! c.get (L"a").if_array (),
+        "const find on packed array");
+    ts.ok (x.find (L"a")->find (1) && *x.get (L"a").find (1)->if_fixnum () == 2
+        && x.get (L"a").packed () == wjson::PACK_NONE, "find unpacks");
+    ts.ok (! x.find (L"a")->find (3), "find out of range");
+}
+
+void
+test_lookup_key (test::simple& ts)
+{
+    wjson::string_type const lengthy (100, L'k');
+    wjson::value_type x = wjson::table ();
+    x.set (L"id", wjson::fixnum (1));
+    x.set (L"caf\u00e9", wjson::fixnum (2));
+    x.set (lengthy, wjson::fixnum (3));
+    wjson::value_type const& c = x;
+    ts.ok (c.find ("id", 2) && c.get ("id", 2).fixnum () == 1
+        && c.get (L"id", 2).fixnum () == 1, "lookup narrow and wide keys");
+    ts.ok (c.exists ("caf\xc3\xa9", 5) && c.get (L"caf\u00e9", 4).fixnum () == 2,
+        "lookup UTF-8 key");
+    std::string const narrow (lengthy.cbegin (), lengthy.cend ());
+    ts.ok (c.get (narrow.data (), narrow.size ()).fixnum () == 3,
+        "lookup key longer than the buffer");
+    ts.ok (! c.find ("i", 1) && ! c.find ("caf\xc3", 4) && ! c.exists ("\xff", 1),
+        "lookup misses and invalid UTF-8");
+    bool thrown = false;
+    try {
+        c.get ("name", 4);
+    }
+    catch (std::out_of_range const&) {
+        thrown = true;
+    }
+    ts.ok (thrown, "get throws on missing key");
+    x.get ("id", 2) = wjson::fixnum (4);
+    ts.ok (x.find (L"id", 2)->fixnum () == 4, "lookup for write");
+}
+
+void
+test_equal_hash (test::simple& ts)
+{
+    wjson::value_type a = wjson::table ();
+    a.set (L"n", wjson::fixnum (1));
+    a.set (L"list", wjson::fixnums ({1, 2}));
+    a.set (L"zero", wjson::flonum (0.0));
+    wjson::value_type b = wjson::table ();
+    b.set (L"zero", wjson::flonum (-0.0));
+    b.set (L"list", wjson::array ());
+    b.get (L"list").push_back (wjson::fixnum (1));
+    b.get (L"list").push_back (wjson::fixnum (2));
+    b.set (L"n", wjson::fixnum (1));
+    ts.ok (a == b && a.hash () == b.hash (), "equal trees and hashes");
+    b.get (L"n").fixnum () = 2;
+    ts.ok (a != b && a.hash () != b.hash (), "mutation clears cached hash");
+    wjson::value_type c = a;
+    ts.ok (c == a && c.hash () == a.hash (), "copy is equal");
+    ts.ok (wjson::string (L"x") != wjson::fixnum (1)
+        && wjson::fixnum (1) != wjson::flonum (1.0), "different tags differ");
+    wjson::hash_table<wjson::value_type, int, wjson::value_hash> seen;
+    seen.insert (std::make_pair (a, 1));
+    b.get (L"n").fixnum () = 1;
+    ts.ok (seen.count (b) == 1 && seen.count (wjson::table ()) == 0,
+        "values key hash_table");
+    wjson::value_type d = wjson::table ();
+    wjson::value_type e = wjson::table ();
+    d[L"a"][L"b"] = wjson::fixnum (1);
+    e[L"a"][L"b"] = wjson::fixnum (2);
+    wjson::value_type& b1 = d.get (L"a").get (L"b");
+    d.hash ();
+    e.hash ();
+    b1 = wjson::fixnum (2);
+    ts.ok (d == e && e == d, "stale cached hash of ancestor");
+    ts.ok (d.hash () == e.hash (), "write to held child drops ancestor hash");
+    wjson::value_type f = e;
+    f.hash ();
+    b1.assign_fixnum (3);
+    ts.ok (d != e && d.hash () != e.hash () && f == e,
+        "cached hashes tell trees apart");
+    seen.insert (std::make_pair (e, 2));
+    ts.ok (seen.count (d) == 0, "hash_table misses changed tree");
+    b1.assign_fixnum (2);
+    ts.ok (seen.count (d) == 1, "hash_table finds tree after write to held child");
+}
+
 int
 main ()
 {
-    test::simple ts (38);
+    test::simple ts (84);
 
     wjson_value_test (ts);
+    test_compact (ts);
+    test_copy_on_write (ts);
+    test_packed (ts);
+    test_emplace (ts);
+    test_intern (ts);
+    test_find (ts);
+    test_lookup_key (ts);
+    test_equal_hash (ts);
 
     return ts.done_testing ();
 }
@@ -2,22 +2,389 @@
 #include <map>
 #include <string>
 #include <utility>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <thread>
 #include "value.hpp"
+#include "decode-number.hpp"
 
 namespace wjson {
 
-value_type::value_type () : mtag (VALUE_NULL)
+// strings and containers live out of line in boxes from allocator_type,
+// so that value_type keeps to a tag and a word.
+template<typename T, typename... A>
+static value_box<T>*
+make_box (A&&... args)
+{
+    allocator_type<value_box<T>> alloc;
+    value_box<T>* const p = alloc.allocate (1);
+    try {
+        new (p) value_box<T> (std::forward<A> (args)...);
+    }
+    catch (...) {
+        alloc.deallocate (p, 1);
+        throw;
+    }
+    return p;
+}
+
+template<typename T>
+static void
+drop_box (value_box<T>* const p)
+{
+#if defined (WJSON_SHARED_VALUE)
+    if (p->mcount.fetch_sub (1, std::memory_order_acq_rel) != 1)
+        return;
+#endif
+    p->~value_box<T> ();
+    allocator_type<value_box<T>> ().deallocate (p, 1);
+}
+
+// new table keys come from the pool of the current intern_scope.
+template<typename S>
+static key_type
+make_key (S&& s)
+{
+    intern_pool_type* const pool = current_pool ();
+    return pool != nullptr ? pool->intern (std::forward<S> (s))
+        : key_type (std::forward<S> (s));
+}
+
+// the element for key, inserted as null when missing.
+template<typename S>
+static value_type&
+slot (table_value_type& table, S&& key)
+{
+    auto const i = table.find (key_type::view (key));
+    if (i != table.end ())
+        return i->second;
+    return table.insert (std::make_pair (make_key (std::forward<S> (key)),
+        value_type ())).first->second;
+}
+
+// a narrow UTF-8 or wide key of lookups in char_type. a key in the
+// encoding of char_type is viewed in place, and the other is converted
+// into the inline buffer, or into a string when it does not fit.
+class lookup_key {
+public:
+    lookup_key (char const* p, std::size_t const n);
+    lookup_key (wchar_t const* p, std::size_t const n);
+    bool valid () const { return mdata != nullptr; }
+    key_type view () const { return key_type::view (mdata, msize); }
+
+private:
+    char_type mbuf[64];
+    string_type mlong;
+    char_type const* mdata;
+    std::size_t msize;
+
+    char_type* buffer (std::size_t const n);
+};
+
+lookup_key::lookup_key (char const* p, std::size_t const n)
+    : mdata (nullptr), msize (0)
+{
+#if defined (WJSON_UTF8_STRING)
+    mdata = p;
+    msize = n;
+#else
+    static const uint32_t LOWERBOUND[5] = {0, 0, 0x80L, 0x0800L, 0x10000L};
+    char_type* const q = buffer (n);
+    std::size_t m = 0;
+    for (std::size_t i = 0; i < n;) {
+        uint32_t code = static_cast<unsigned char> (p[i]);
+        int const length = code < 0x80 ? 1 : (code & 0xe0) == 0xc0 ? 2
+            : (code & 0xf0) == 0xe0 ? 3 : (code & 0xf8) == 0xf0 ? 4 : 0;
+        if (length == 0 || n - i < static_cast<std::size_t> (length))
+            return;
+        code &= 0x7f >> (length - 1);
+        for (int k = 1; k < length; ++k) {
+            uint32_t const octet = static_cast<unsigned char> (p[i + k]);
+            if ((octet & 0xc0) != 0x80)
+                return;
+            code = (code << 6) | (octet & 0x3f);
+        }
+        if (code < LOWERBOUND[length] || 0x10ffffL < code
+                || (0xd800L <= code && code <= 0xdfffL))
+            return;
+        q[m++] = code;
+        i += length;
+    }
+    mdata = q;
+    msize = m;
+#endif
+}
+
+lookup_key::lookup_key (wchar_t const* p, std::size_t const n)
+    : mdata (nullptr), msize (0)
+{
+#if defined (WJSON_UTF8_STRING)
+    char_type* const q = buffer (n * 4);
+    std::size_t m = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        uint32_t const uc = static_cast<uint32_t> (p[i]);
+        if (0x10ffffL < uc || (0xd800L <= uc && uc <= 0xdfffL))
+            return;
+        if (uc < 0x80)
+            q[m++] = uc;
+        else if (uc < 0x800) {
+            q[m++] = ((uc >>  6) & 0xff) | 0xc0;
+            q[m++] = ( uc        & 0x3f) | 0x80;
+        }
+        else if (uc < 0x10000) {
+            q[m++] = ((uc >> 12) & 0x0f) | 0xe0;
+            q[m++] = ((uc >>  6) & 0x3f) | 0x80;
+            q[m++] = ( uc        & 0x3f) | 0x80;
+        }
+        else {
+            q[m++] = ((uc >> 18) & 0x07) | 0xf0;
+            q[m++] = ((uc >> 12) & 0x3f) | 0x80;
+            q[m++] = ((uc >>  6) & 0x3f) | 0x80;
+            q[m++] = ( uc        & 0x3f) | 0x80;
+        }
+    }
+    mdata = q;
+    msize = m;
+#else
+    mdata = p;
+    msize = n;
+#endif
+}
+
+char_type*
+lookup_key::buffer (std::size_t const n)
+{
+    if (n <= sizeof (mbuf) / sizeof (mbuf[0]))
+        return mbuf;
+    mlong.resize (n);
+    return &mlong[0];
+}
+
+// the element for a pointer and length key, or nullptr.
+template<typename T, typename C>
+static auto
+find_entry (T& table, C const* key, std::size_t const n)
+    -> decltype (&table.begin ()->second)
+{
+    lookup_key const k (key, n);
+    if (! k.valid ())
+        return nullptr;
+    auto const i = table.find (k.view ());
+    return i == table.end () ? nullptr : &i->second;
+}
+
+// whether dropping the box frees it.
+template<typename T>
+static bool
+sole_box (value_box<T>* const p)
+{
+#if defined (WJSON_SHARED_VALUE)
+    return p->mcount.load (std::memory_order_acquire) == 1;
+#else
+    return true;
+#endif
+}
+
+static bool
+nested (value_type const& x)
+{
+    return ((x.tag () == VALUE_ARRAY && x.packed () == PACK_NONE)
+        || x.tag () == VALUE_TABLE) && x.size () > 0;
+}
+
+// with -DWJSON_ARENA a copy shares the boxes of its own arena only,
+// so that a copy made out of a document outlives it.
+template<typename T>
+static value_box<T>*
+share_box (value_box<T>* const p)
+{
+#if defined (WJSON_SHARED_VALUE)
+#if defined (WJSON_ARENA)
+    if (allocator_type<value_box<T>>::arena_of (p) == current_arena ())
+#endif
+    {
+        p->mcount.fetch_add (1, std::memory_order_relaxed);
+        return p;
+    }
+#endif
+    value_box<T>* const q = make_box<T> (p->mdata);
+    q->mhash.store (p->mhash.load (std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    q->mepoch.store (p->mepoch.load (std::memory_order_acquire),
+        std::memory_order_release);
+    return q;
+}
+
+// copy a shared box on write.
+template<typename T>
+static value_box<T>*
+own_box (value_box<T>* const p)
+{
+#if defined (WJSON_SHARED_VALUE)
+    if (p->mcount.load (std::memory_order_acquire) != 1) {
+        value_box<T>* const q = make_box<T> (p->mdata);
+        drop_box (p);
+        return q;
+    }
+#endif
+    return p;
+}
+
+// cached hashes and resolved setters hold for the epoch they were made
+// in. a write through the non-const accessors starts a new epoch when
+// any of them has watched the epoch since the last one, so that a write
+// to a child also drops the hashes of its ancestors.
+static std::atomic<std::size_t> write_epoch (1);
+static std::atomic<bool> writes_watched (false);
+
+static void
+touch_epoch ()
+{
+    if (writes_watched.load (std::memory_order_relaxed)) {
+        writes_watched.store (false, std::memory_order_relaxed);
+        write_epoch.fetch_add (1, std::memory_order_relaxed);
+    }
+}
+
+std::size_t
+watch_writes ()
+{
+    if (! writes_watched.load (std::memory_order_relaxed))
+        writes_watched.store (true, std::memory_order_relaxed);
+    return write_epoch.load (std::memory_order_relaxed);
+}
+
+number_literal_type::number_literal_type (std::string const& s)
+    : mtext (s.cbegin (), s.cend ()), mfixnum (0), mstate (LITERAL_TEXT)
+{
+}
+
+// a copy keeps the number when it is ready, or converts again.
+number_literal_type::number_literal_type (number_literal_type const& x)
+    : mtext (x.mtext), mfixnum (0), mstate (LITERAL_TEXT)
+{
+    int const state = x.mstate.load (std::memory_order_acquire);
+    if (state == LITERAL_NUMBER || state == LITERAL_RANGE) {
+        std::memcpy (&mfixnum, &x.mfixnum, sizeof (mfixnum));
+        mstate.store (state, std::memory_order_relaxed);
+    }
+}
+
+// converts a literal on the first read. readers that meet another
+// converting it wait for the number.
+static bool
+convert_literal (number_literal_type& x, variation const tag)
+{
+    int state = x.mstate.load (std::memory_order_acquire);
+    if (state == number_literal_type::LITERAL_TEXT
+            && x.mstate.compare_exchange_strong (state,
+                number_literal_type::LITERAL_BUSY, std::memory_order_acquire)) {
+        char const* const first = x.mtext.data ();
+        char const* const last = first + x.mtext.size ();
+        bool const ok = tag == VALUE_FIXNUM ? decode_fixnum (first, last, x.mfixnum)
+            : decode_flonum (first, last, x.mflonum);
+        state = ok ? number_literal_type::LITERAL_NUMBER
+            : number_literal_type::LITERAL_RANGE;
+        x.mstate.store (state, std::memory_order_release);
+    }
+    while (state == number_literal_type::LITERAL_BUSY) {
+        std::this_thread::yield ();
+        state = x.mstate.load (std::memory_order_acquire);
+    }
+    return state == number_literal_type::LITERAL_NUMBER;
+}
+
+// whether a number has a value, that is not a literal out of range.
+static bool
+in_range (value_type const& x)
+{
+    return x.tag () == VALUE_FIXNUM ? x.if_fixnum () != nullptr
+        : x.if_flonum () != nullptr;
+}
+
+static std::size_t
+hash_combine (std::size_t const h, std::size_t const x)
+{
+    return h ^ (x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+static std::size_t
+hash_fixnum (int64_t const x)
+{
+    return hash_combine (VALUE_FIXNUM, static_cast<std::size_t> (x));
+}
+
+// 0.0 and -0.0 are equal.
+static std::size_t
+hash_flonum (double const x)
+{
+    uint64_t bits = 0;
+    if (x != 0.0)
+        std::memcpy (&bits, &x, sizeof (bits));
+    return hash_combine (VALUE_FLONUM, static_cast<std::size_t> (bits));
+}
+
+static std::size_t
+hash_boolean (bool const x)
+{
+    return hash_combine (VALUE_BOOLEAN, x ? 1 : 0);
+}
+
+// the hash of a box cached in the current epoch, or 0.
+template<typename T>
+static std::size_t
+known_hash (value_box<T> const* const p)
+{
+    return p->mepoch.load (std::memory_order_acquire)
+        == write_epoch.load (std::memory_order_relaxed)
+        ? p->mhash.load (std::memory_order_relaxed) : 0;
+}
+
+// the hash of a box computed once an epoch.
+template<typename T, typename F>
+static std::size_t
+cached_hash (value_box<T>* const p, F compute)
+{
+    std::size_t const epoch = watch_writes ();
+    if (p->mepoch.load (std::memory_order_acquire) == epoch)
+        return p->mhash.load (std::memory_order_relaxed);
+    std::size_t h = compute (p->mdata);
+    if (h == 0)
+        h = 1;
+    p->mhash.store (h, std::memory_order_relaxed);
+    p->mepoch.store (epoch, std::memory_order_release);
+    return h;
+}
+
+// an element of a packed array equals to x.
+static bool
+equal_element (value_type const& x, value_type const& packed, std::size_t const i)
+{
+    switch (packed.packed ()) {
+    case PACK_BOOLEAN:
+        return x.tag () == VALUE_BOOLEAN && x.boolean () == packed.booleans ()[i];
+    case PACK_FIXNUM:
+        return x.if_fixnum () != nullptr && *x.if_fixnum () == packed.fixnums ()[i];
+    case PACK_FLONUM:
+        return x.if_flonum () != nullptr && *x.if_flonum () == packed.flonums ()[i];
+    default:
+        return false;
+    }
+}
+
+value_type::value_type () : mtag (VALUE_NULL), mpack (PACK_NONE)
 {
     mboolean = false;
 }
 
-value_type::value_type (value_type const& x) : mtag (x.mtag)
+value_type::value_type (value_type const& x) : mtag (x.mtag), mpack (x.mpack)
 {
     copy_data (x);
 }
 
-value_type::value_type (value_type&& x) : mtag (x.mtag)
+value_type::value_type (value_type&& x) noexcept
+    : mtag (x.mtag), mpack (x.mpack)
 {
     move_data (std::move (x));
 }
@@ -27,24 +394,31 @@ value_type::~value_type ()
     destroy ();
 }
 
+// x may be a part of this tree, so that take it before destroy.
 value_type&
 value_type::operator=(value_type const& x)
 {
     if (this != &x) {
+        value_type tmp (x);
+        touch_epoch ();
         destroy ();
-        mtag = x.mtag;
-        copy_data (x);
+        mtag = tmp.mtag;
+        mpack = tmp.mpack;
+        move_data (std::move (tmp));
     }
     return *this;
 }
 
 value_type&
-value_type::operator=(value_type&& x)
+value_type::operator=(value_type&& x) noexcept
 {
     if (this != &x) {
+        value_type tmp (std::move (x));
+        touch_epoch ();
         destroy ();
-        mtag = x.mtag;
-        move_data (std::move (x));
+        mtag = tmp.mtag;
+        mpack = tmp.mpack;
+        move_data (std::move (tmp));
     }
     return *this;
 }
@@ -52,6 +426,7 @@ value_type::operator=(value_type&& x)
 value_type&
 value_type::assign_null ()
 {
+    touch_epoch ();
     destroy ();
     mtag = VALUE_NULL;
     mboolean = false;
@@ -61,6 +436,7 @@ value_type::assign_null ()
 value_type&
 value_type::assign_boolean (bool const x)
 {
+    touch_epoch ();
     destroy ();
     mtag = VALUE_BOOLEAN;
     mboolean = x;
@@ -70,6 +446,7 @@ value_type::assign_boolean (bool const x)
 value_type&
 value_type::assign_fixnum (int64_t const x)
 {
+    touch_epoch ();
     destroy ();
     mtag = VALUE_FIXNUM;
     mfixnum = x;
@@ -83,81 +460,187 @@ value_type::assign_flonum (double const x)
         throw std::out_of_range ("value_type(double): nan invalid.");
     if (std::isinf (x))
         throw std::out_of_range ("value_type(double): inf invalid.");
+    touch_epoch ();
     destroy ();
     mtag = VALUE_FLONUM;
     mflonum = x;
     return *this;
 }
 
+// keeps a number literal of the decoders to convert on the first read.
 value_type&
-value_type::assign_datetime (std::wstring const& x)
+value_type::assign_number_literal (std::string const& x)
 {
+    value_box<number_literal_type>* const p = make_box<number_literal_type> (x);
+    touch_epoch ();
     destroy ();
-    mtag = VALUE_DATETIME;
-    new (&mstring) std::wstring (x);
-    return *this;    
+    mtag = x.find_first_of (".eE") == std::string::npos ? VALUE_FIXNUM : VALUE_FLONUM;
+    mpack = PACK_LITERAL;
+    mliteral = p;
+    return *this;
 }
 
 value_type&
-value_type::assign_datetime (std::wstring&& x)
+value_type::assign_datetime (datetime_type const& x)
 {
+    value_box<datetime_type>* const p = make_box<datetime_type> (x);
+    touch_epoch ();
     destroy ();
     mtag = VALUE_DATETIME;
-    new (&mstring) std::wstring (std::move (x));
-    return *this;    
+    mdatetime = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_datetime (string_type const& x)
+{
+    std::string octets;
+    for (auto c : x) {
+        if (static_cast<uint32_t> (c) >= 0x80)
+            throw std::out_of_range ("assign_datetime(x): invalid");
+        octets.push_back (static_cast<char> (c));
+    }
+    datetime_type t;
+    if (! decode_datetime (octets, t))
+        throw std::out_of_range ("assign_datetime(x): invalid");
+    return assign_datetime (t);
 }
 
 value_type&
-value_type::assign_string (std::wstring const& x)
+value_type::assign_string (string_type const& x)
 {
+    value_box<string_type>* const p = make_box<string_type> (x);
+    touch_epoch ();
     destroy ();
     mtag = VALUE_STRING;
-    new (&mstring) std::wstring (x);
+    mstring = p;
     return *this;    
 }
 
 value_type&
-value_type::assign_string (std::wstring&& x)
+value_type::assign_string (string_type&& x)
 {
+    value_box<string_type>* const p = make_box<string_type> (std::move (x));
+    touch_epoch ();
     destroy ();
     mtag = VALUE_STRING;
-    new (&mstring) std::wstring (std::move (x));
+    mstring = p;
     return *this;    
 }
 
 value_type&
 value_type::assign_array (array_value_type const& x)
 {
+    value_box<array_value_type>* const p = make_box<array_value_type> (x);
+    touch_epoch ();
     destroy ();
     mtag = VALUE_ARRAY;
-    new (&marray) array_value_type (x);
+    marray = p;
     return *this;    
 }
 
 value_type&
 value_type::assign_array (array_value_type&& x)
 {
+    value_box<array_value_type>* const p = make_box<array_value_type> (std::move (x));
+    touch_epoch ();
     destroy ();
     mtag = VALUE_ARRAY;
-    new (&marray) array_value_type (std::move (x));
+    marray = p;
     return *this;    
 }
 
 value_type&
 value_type::assign_table (table_value_type const& x)
 {
+    value_box<table_value_type>* const p = make_box<table_value_type> (x);
+    touch_epoch ();
     destroy ();
     mtag = VALUE_TABLE;
-    new (&mtable) table_value_type (x);
+    mtable = p;
     return *this;    
 }
 
 value_type&
 value_type::assign_table (table_value_type&& x)
 {
+    value_box<table_value_type>* const p = make_box<table_value_type> (std::move (x));
+    touch_epoch ();
     destroy ();
     mtag = VALUE_TABLE;
-    new (&mtable) table_value_type (std::move (x));
+    mtable = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_booleans (boolean_array_type const& x)
+{
+    value_box<boolean_array_type>* const p = make_box<boolean_array_type> (x);
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_BOOLEAN;
+    mbooleans = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_booleans (boolean_array_type&& x)
+{
+    value_box<boolean_array_type>* const p = make_box<boolean_array_type> (std::move (x));
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_BOOLEAN;
+    mbooleans = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_fixnums (fixnum_array_type const& x)
+{
+    value_box<fixnum_array_type>* const p = make_box<fixnum_array_type> (x);
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_FIXNUM;
+    mfixnums = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_fixnums (fixnum_array_type&& x)
+{
+    value_box<fixnum_array_type>* const p = make_box<fixnum_array_type> (std::move (x));
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_FIXNUM;
+    mfixnums = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_flonums (flonum_array_type const& x)
+{
+    value_box<flonum_array_type>* const p = make_box<flonum_array_type> (x);
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_FLONUM;
+    mflonums = p;
+    return *this;
+}
+
+value_type&
+value_type::assign_flonums (flonum_array_type&& x)
+{
+    value_box<flonum_array_type>* const p = make_box<flonum_array_type> (std::move (x));
+    touch_epoch ();
+    destroy ();
+    mtag = VALUE_ARRAY;
+    mpack = PACK_FLONUM;
+    mflonums = p;
     return *this;
 }
 
@@ -165,7 +648,7 @@ setter_type
 value_type::operator[] (value_type const& k)
 {
     if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return setter_type (*this, k.mstring);
+        return setter_type (*this, k.mstring->mdata);
     throw std::out_of_range ("value_type::[](value)const: invalid");
 }
 
@@ -178,7 +661,7 @@ value_type::operator[] (std::size_t idx)
 }
 
 setter_type
-value_type::operator[] (std::wstring const& key)
+value_type::operator[] (string_type const& key)
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("value_type::[](key)const: not table");
@@ -189,7 +672,7 @@ bool
 value_type::exists (value_type const& k) const
 {
     if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return mtable.count (k.mstring) > 0;
+        return mtable->mdata.count (key_type::view (k.mstring->mdata)) > 0;
     throw std::out_of_range ("value_type::exists(value)const: invalid");
 }
 
@@ -197,15 +680,15 @@ bool
 value_type::exists (std::size_t const idx) const
 {
     if (mtag == VALUE_ARRAY)
-        return idx < marray.size ();
+        return idx < size ();
     throw std::out_of_range ("value_type::exists(idx)const: not array");
 }
 
 bool
-value_type::exists (std::wstring const& key) const
+value_type::exists (string_type const& key) const
 {
     if (mtag == VALUE_TABLE)
-        return mtable.count (key) > 0;
+        return mtable->mdata.count (key_type::view (key)) > 0;
     throw std::out_of_range ("value_type::exists(key)const: invalid");
 }
 
@@ -213,16 +696,18 @@ value_type const&
 value_type::get (value_type const& k) const
 {
     if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return mtable.at (k.mstring);
+        return mtable->mdata.at (key_type::view (k.mstring->mdata));
     throw std::out_of_range ("value_type::get(value)const: invalid");
 }
 
 value_type&
 value_type::get (value_type const& k)
 {
-    if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return mtable.at (k.mstring);
-    throw std::out_of_range ("value_type::get(value)const: invalid");    
+    if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING) {
+        unshare ();
+        return mtable->mdata.at (key_type::view (k.mstring->mdata));
+    }
+    throw std::out_of_range ("value_type::get(value): invalid");
 }
 
 value_type const&
@@ -230,7 +715,9 @@ value_type::get (std::size_t const idx) const
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::get(idx)const: not array");
-    return marray.at (idx);
+    if (mpack != PACK_NONE)
+        throw std::out_of_range ("value_type::get(idx)const: packed array");
+    return marray->mdata.at (idx);
 }
 
 value_type&
@@ -238,30 +725,133 @@ value_type::get (std::size_t const idx)
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::get(idx): not array");
-    return marray.at (idx);
+    unpack ();
+    unshare ();
+    return marray->mdata.at (idx);
 }
 
 value_type const&
-value_type::get (std::wstring const& key) const
+value_type::get (string_type const& key) const
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("value_type::get(key)const: not table");
-    return mtable.at (key);
+    return mtable->mdata.at (key_type::view (key));
 }
 
 value_type&
-value_type::get (std::wstring const& key)
+value_type::get (string_type const& key)
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("value_type::get(key): not table");
-    return mtable.at (key);
+    unshare ();
+    return mtable->mdata.at (key_type::view (key));
+}
+
+value_type const*
+value_type::find (value_type const& k) const
+{
+    if (k.mtag != VALUE_STRING)
+        return nullptr;
+    return find (k.mstring->mdata);
+}
+
+value_type*
+value_type::find (value_type const& k)
+{
+    if (k.mtag != VALUE_STRING)
+        return nullptr;
+    return find (k.mstring->mdata);
+}
+
+value_type const*
+value_type::find (std::size_t const idx) const
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_NONE || idx >= marray->mdata.size ())
+        return nullptr;
+    return &marray->mdata[idx];
+}
+
+value_type*
+value_type::find (std::size_t const idx)
+{
+    if (mtag != VALUE_ARRAY || idx >= size ())
+        return nullptr;
+    unpack ();
+    unshare ();
+    return &marray->mdata[idx];
+}
+
+value_type
+value_type::element (std::size_t const idx) const
+{
+    if (mtag != VALUE_ARRAY)
+        throw std::out_of_range ("value_type::element(idx)const: not array");
+    if (idx >= size ())
+        throw std::out_of_range ("value_type::element(idx)const: out of range");
+    switch (mpack) {
+    case PACK_BOOLEAN: return ::wjson::boolean (mbooleans->mdata[idx]);
+    case PACK_FIXNUM:  return ::wjson::fixnum (mfixnums->mdata[idx]);
+    case PACK_FLONUM:  return ::wjson::flonum (mflonums->mdata[idx]);
+    default: return marray->mdata[idx];
+    }
+}
+
+array_elements_type
+value_type::elements () const
+{
+    if (mtag != VALUE_ARRAY)
+        throw std::out_of_range ("value_type::elements()const: not array");
+    return array_elements_type (*this);
+}
+
+// an element of a packed array goes into scalar without the assignments,
+// which would end the epoch of writes.
+value_type const&
+array_elements_type::at (value_type const& array, std::size_t const idx,
+    value_type& scalar)
+{
+    switch (array.mpack) {
+    case PACK_BOOLEAN:
+        scalar.mtag = VALUE_BOOLEAN;
+        scalar.mboolean = array.mbooleans->mdata[idx];
+        return scalar;
+    case PACK_FIXNUM:
+        scalar.mtag = VALUE_FIXNUM;
+        scalar.mfixnum = array.mfixnums->mdata[idx];
+        return scalar;
+    case PACK_FLONUM:
+        scalar.mtag = VALUE_FLONUM;
+        scalar.mflonum = array.mflonums->mdata[idx];
+        return scalar;
+    default:
+        return array.marray->mdata[idx];
+    }
+}
+
+value_type const*
+value_type::find (string_type const& key) const
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    auto const i = mtable->mdata.find (key_type::view (key));
+    return i == mtable->mdata.end () ? nullptr : &i->second;
+}
+
+value_type*
+value_type::find (string_type const& key)
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    unshare ();
+    auto const i = mtable->mdata.find (key_type::view (key));
+    return i == mtable->mdata.end () ? nullptr : &i->second;
 }
 
 value_type&
 value_type::set (value_type const& k, value_type const& x)
 {
     if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return set (k.mstring, x);
+        return set (k.mstring->mdata, x);
     throw std::out_of_range ("value_type::set(value,const&x)const: invalid");    
 }
 
@@ -269,7 +859,7 @@ value_type&
 value_type::set (value_type const& k, value_type&& x)
 {
     if (mtag == VALUE_TABLE && k.mtag == VALUE_STRING)
-        return set (k.mstring, std::move (x));
+        return set (k.mstring->mdata, std::move (x));
     throw std::out_of_range ("value_type::set(value,&&x)const: invalid");    
 }
 
@@ -278,9 +868,11 @@ value_type::set (std::size_t const idx, value_type const& x)
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::set(idx,const&x): not array");
-    if (idx >= marray.size ())
-        marray.resize (idx + 1);
-    marray[idx] = x;
+    unpack ();
+    unshare ();
+    if (idx >= marray->mdata.size ())
+        marray->mdata.resize (idx + 1);
+    marray->mdata[idx] = x;
     return *this;
 }
 
@@ -289,9 +881,11 @@ value_type::set (std::size_t const idx, value_type&& x)
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::set(idx,&&x): not array");
-    if (idx >= marray.size ())
-        marray.resize (idx + 1);
-    std::swap (marray[idx], x);
+    unpack ();
+    unshare ();
+    if (idx >= marray->mdata.size ())
+        marray->mdata.resize (idx + 1);
+    marray->mdata[idx] = std::move (x);
     return *this;
 }
 
@@ -300,7 +894,9 @@ value_type::push_back (value_type const& x)
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::set(idx,const&x): not array");
-    marray.push_back (x);
+    unpack ();
+    unshare ();
+    marray->mdata.push_back (x);
     return *this;
 }
 
@@ -309,39 +905,288 @@ value_type::push_back (value_type&& x)
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("value_type::set(idx,&&x): not array");
-    marray.push_back (std::move (x));
+    unpack ();
+    unshare ();
+    marray->mdata.push_back (std::move (x));
     return *this;
 }
 
 value_type&
-value_type::set (std::wstring const& key, value_type const& x)
+value_type::set (string_type const& key, value_type const& x)
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("value_type::set(key,const&x): not array");
-    mtable[key] = x;
+    unshare ();
+    slot (mtable->mdata, key) = x;
     return *this;
 }
 
 value_type&
-value_type::set (std::wstring const& key, value_type&& x)
+value_type::set (string_type const& key, value_type&& x)
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("value_type::set(key,&&x): not array");
-    std::swap (mtable[key], x);
+    unshare ();
+    slot (mtable->mdata, key) = std::move (x);
+    return *this;
+}
+
+value_type&
+value_type::set (string_type&& key, value_type&& x)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::set(&&key,&&x): not table");
+    unshare ();
+    slot (mtable->mdata, std::move (key)) = std::move (x);
     return *this;
 }
 
+value_type&
+value_type::emplace_back ()
+{
+    if (mtag != VALUE_ARRAY)
+        throw std::out_of_range ("value_type::emplace_back(): not array");
+    unpack ();
+    unshare ();
+    marray->mdata.emplace_back ();
+    return marray->mdata.back ();
+}
+
+value_type&
+value_type::emplace_back (value_type&& x)
+{
+    if (mtag != VALUE_ARRAY)
+        throw std::out_of_range ("value_type::emplace_back(&&x): not array");
+    unpack ();
+    unshare ();
+    marray->mdata.emplace_back (std::move (x));
+    return marray->mdata.back ();
+}
+
+value_type&
+value_type::emplace (string_type const& key)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::emplace(key): not table");
+    unshare ();
+    return slot (mtable->mdata, key);
+}
+
+value_type&
+value_type::emplace (string_type&& key)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::emplace(&&key): not table");
+    unshare ();
+    return slot (mtable->mdata, std::move (key));
+}
+
+value_type&
+value_type::emplace (string_type&& key, value_type&& x)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::emplace(&&key,&&x): not table");
+    unshare ();
+    auto const i = mtable->mdata.find (key_type::view (key));
+    if (i != mtable->mdata.end ())
+        return i->second;
+    return mtable->mdata.insert (std::make_pair (make_key (std::move (key)),
+        std::move (x))).first->second;
+}
+
+// tables reserve with WJSON_HASH_TABLE only, std::map has no capacity.
 void
-value_type::swap (value_type& x)
+value_type::reserve (std::size_t const n)
+{
+    if (mtag == VALUE_ARRAY) {
+        unshare ();
+        switch (mpack) {
+        case PACK_NONE:    marray->mdata.reserve (n); break;
+        case PACK_BOOLEAN: mbooleans->mdata.reserve (n); break;
+        case PACK_FIXNUM:  mfixnums->mdata.reserve (n); break;
+        case PACK_FLONUM:  mflonums->mdata.reserve (n); break;
+        default: break;
+        }
+    }
+#if defined (WJSON_HASH_TABLE)
+    else if (mtag == VALUE_TABLE) {
+        unshare ();
+        mtable->mdata.reserve (n);
+    }
+#endif
+    else
+        throw std::out_of_range ("value_type::reserve(n): not container");
+}
+
+void
+value_type::swap (value_type& x) noexcept
 {
     if (this != &x) {
         value_type tmp (std::move (*this));
-        mtag = x.mtag;
-        move_data (std::move (x));
+        *this = std::move (x);
         x = std::move (tmp);
     }
 }
 
+bool
+value_type::equal (value_type const& x) const
+{
+    if (this == &x)
+        return true;
+    if (mtag != x.mtag)
+        return false;
+    switch (mtag) {
+    case VALUE_NULL: return true;
+    case VALUE_BOOLEAN: return mboolean == x.mboolean;
+    case VALUE_FIXNUM:
+    case VALUE_FLONUM:
+        // literals out of range equal by their text only.
+        if (! in_range (*this) || ! in_range (x))
+            return literal () != nullptr && x.literal () != nullptr
+                && *literal () == *x.literal ();
+        return mtag == VALUE_FIXNUM ? *if_fixnum () == *x.if_fixnum ()
+            : *if_flonum () == *x.if_flonum ();
+    case VALUE_DATETIME: return mdatetime->mdata == x.mdatetime->mdata;
+    default: break;
+    }
+    // boxes of the same pointer are equal, and boxes whose hashes
+    // are cached in this epoch differ when their hashes do.
+    auto const box = [](value_type const& v) -> void const* {
+        switch (v.mtag == VALUE_ARRAY ? v.mpack : PACK_NONE) {
+        case PACK_BOOLEAN: return v.mbooleans;
+        case PACK_FIXNUM: return v.mfixnums;
+        case PACK_FLONUM: return v.mflonums;
+        default: break;
+        }
+        return v.mtag == VALUE_STRING ? static_cast<void const*> (v.mstring)
+            : v.mtag == VALUE_ARRAY ? static_cast<void const*> (v.marray)
+            : static_cast<void const*> (v.mtable);
+    };
+    auto const known = [](value_type const& v) -> std::size_t {
+        switch (v.mtag == VALUE_ARRAY ? v.mpack : PACK_NONE) {
+        case PACK_BOOLEAN: return known_hash (v.mbooleans);
+        case PACK_FIXNUM: return known_hash (v.mfixnums);
+        case PACK_FLONUM: return known_hash (v.mflonums);
+        default: break;
+        }
+        return v.mtag == VALUE_STRING ? known_hash (v.mstring)
+            : v.mtag == VALUE_ARRAY ? known_hash (v.marray)
+            : known_hash (v.mtable);
+    };
+    if (box (*this) == box (x))
+        return true;
+    std::size_t const h = known (*this);
+    std::size_t const hx = h != 0 ? known (x) : 0;
+    if (hx != 0 && h != hx)
+        return false;
+    if (mtag == VALUE_STRING)
+        return mstring->mdata == x.mstring->mdata;
+    if (mtag == VALUE_TABLE) {
+        if (mtable->mdata.size () != x.mtable->mdata.size ())
+            return false;
+        for (auto const& e : mtable->mdata) {
+            auto const i = x.mtable->mdata.find (e.first);
+            if (i == x.mtable->mdata.end () || ! e.second.equal (i->second))
+                return false;
+        }
+        return true;
+    }
+    std::size_t const n = size ();
+    if (n != x.size ())
+        return false;
+    if (mpack == x.mpack) {
+        switch (mpack) {
+        case PACK_NONE:
+            return std::equal (marray->mdata.cbegin (), marray->mdata.cend (),
+                x.marray->mdata.cbegin (),
+                [](value_type const& a, value_type const& b) { return a.equal (b); });
+        case PACK_BOOLEAN: return mbooleans->mdata == x.mbooleans->mdata;
+        case PACK_FIXNUM: return mfixnums->mdata == x.mfixnums->mdata;
+        case PACK_FLONUM: return mflonums->mdata == x.mflonums->mdata;
+        default: break;
+        }
+    }
+    if (mpack != PACK_NONE && x.mpack != PACK_NONE)
+        return n == 0;
+    value_type const& packed = mpack != PACK_NONE ? *this : x;
+    value_type const& plain = mpack != PACK_NONE ? x : *this;
+    for (std::size_t i = 0; i < n; ++i)
+        if (! equal_element (plain.marray->mdata[i], packed, i))
+            return false;
+    return true;
+}
+
+std::size_t
+value_type::hash () const
+{
+    switch (mtag) {
+    case VALUE_NULL: return hash_combine (VALUE_NULL, 0);
+    case VALUE_BOOLEAN: return hash_boolean (mboolean);
+    case VALUE_FIXNUM:
+    case VALUE_FLONUM:
+        if (! in_range (*this)) {
+            std::size_t h = hash_combine (mtag, mliteral->mdata.mtext.size ());
+            for (char const c : mliteral->mdata.mtext)
+                h = hash_combine (h, static_cast<unsigned char> (c));
+            return h;
+        }
+        return mtag == VALUE_FIXNUM ? hash_fixnum (*if_fixnum ())
+            : hash_flonum (*if_flonum ());
+    case VALUE_DATETIME:
+        return hash_combine (hash_combine (hash_combine (hash_combine (VALUE_DATETIME,
+            mdatetime->mdata.mseconds), mdatetime->mdata.mnanosecond),
+            mdatetime->mdata.moffset), mdatetime->mdata.mform);
+    case VALUE_STRING:
+        return cached_hash (mstring, [](string_type const& x) {
+            return hash_combine (VALUE_STRING, key_type::view (x).hash ());
+        });
+    case VALUE_TABLE:
+        // the sum of entries does not depend on their order.
+        return cached_hash (mtable, [](table_value_type const& x) {
+            std::size_t h = 0;
+            for (auto const& e : x)
+                h += hash_combine (e.first.hash (), e.second.hash ());
+            return hash_combine (hash_combine (VALUE_TABLE, x.size ()), h);
+        });
+    case VALUE_ARRAY:
+        break;
+    }
+    std::size_t const init = hash_combine (VALUE_ARRAY, size ());
+    switch (mpack) {
+    case PACK_NONE:
+        return cached_hash (marray, [init](array_value_type const& x) {
+            std::size_t h = init;
+            for (auto const& e : x)
+                h = hash_combine (h, e.hash ());
+            return h;
+        });
+    case PACK_BOOLEAN:
+        return cached_hash (mbooleans, [init](boolean_array_type const& x) {
+            std::size_t h = init;
+            for (bool const e : x)
+                h = hash_combine (h, hash_boolean (e));
+            return h;
+        });
+    case PACK_FIXNUM:
+        return cached_hash (mfixnums, [init](fixnum_array_type const& x) {
+            std::size_t h = init;
+            for (int64_t const e : x)
+                h = hash_combine (h, hash_fixnum (e));
+            return h;
+        });
+    case PACK_FLONUM:
+        return cached_hash (mflonums, [init](flonum_array_type const& x) {
+            std::size_t h = init;
+            for (double const e : x)
+                h = hash_combine (h, hash_flonum (e));
+            return h;
+        });
+    default:
+        break;
+    }
+    return init;
+}
+
 variation
 value_type::tag () const
 {
@@ -352,10 +1197,15 @@ std::size_t
 value_type::size () const
 {
     switch (mtag) {
-    case VALUE_DATETIME: return mstring.size ();
-    case VALUE_STRING: return mstring.size ();
-    case VALUE_ARRAY:  return marray.size ();
-    case VALUE_TABLE:  return mtable.size ();
+    case VALUE_STRING: return mstring->mdata.size ();
+    case VALUE_ARRAY:
+        switch (mpack) {
+        case PACK_BOOLEAN: return mbooleans->mdata.size ();
+        case PACK_FIXNUM:  return mfixnums->mdata.size ();
+        case PACK_FLONUM:  return mflonums->mdata.size ();
+        default: return marray->mdata.size ();
+        }
+    case VALUE_TABLE:  return mtable->mdata.size ();
     default: return 0;
     }
 }
@@ -373,6 +1223,7 @@ value_type::boolean ()
 {
     if (mtag != VALUE_BOOLEAN)
         throw std::out_of_range ("boolean(): not boolean");
+    touch_epoch ();
     return mboolean;
 }
 
@@ -381,7 +1232,10 @@ value_type::fixnum () const
 {
     if (mtag != VALUE_FIXNUM)
         throw std::out_of_range ("fixnum()const: not fixnum");
-    return mfixnum;
+    int64_t const* const p = if_fixnum ();
+    if (p == nullptr)
+        throw std::out_of_range ("fixnum()const: literal out of range");
+    return *p;
 }
 
 int64_t&
@@ -389,6 +1243,16 @@ value_type::fixnum ()
 {
     if (mtag != VALUE_FIXNUM)
         throw std::out_of_range ("fixnum(): not fixnum");
+    touch_epoch ();
+    if (mpack == PACK_LITERAL) {
+        int64_t const* const p = if_fixnum ();
+        if (p == nullptr)
+            throw std::out_of_range ("fixnum(): literal out of range");
+        int64_t const x = *p;
+        drop_box (mliteral);
+        mpack = PACK_NONE;
+        mfixnum = x;
+    }
     return mfixnum;
 }
 
@@ -397,7 +1261,10 @@ value_type::flonum () const
 {
     if (mtag != VALUE_FLONUM)
         throw std::out_of_range ("flonum()const: not flonum");
-    return mflonum;
+    double const* const p = if_flonum ();
+    if (p == nullptr)
+        throw std::out_of_range ("flonum()const: literal out of range");
+    return *p;
 }
 
 double&
@@ -405,39 +1272,58 @@ value_type::flonum ()
 {
     if (mtag != VALUE_FLONUM)
         throw std::out_of_range ("flonum(): not flonum");
+    touch_epoch ();
+    if (mpack == PACK_LITERAL) {
+        double const* const p = if_flonum ();
+        if (p == nullptr)
+            throw std::out_of_range ("flonum(): literal out of range");
+        double const x = *p;
+        drop_box (mliteral);
+        mpack = PACK_NONE;
+        mflonum = x;
+    }
     return mflonum;
 }
 
-std::wstring const&
+literal_string_type const*
+value_type::literal () const
+{
+    return (mtag == VALUE_FIXNUM || mtag == VALUE_FLONUM) && mpack == PACK_LITERAL
+        ? &mliteral->mdata.mtext : nullptr;
+}
+
+datetime_type const&
 value_type::datetime () const
 {
     if (mtag != VALUE_DATETIME)
         throw std::out_of_range ("datetime()const: not datetime");
-    return mstring;
+    return mdatetime->mdata;
 }
 
-std::wstring&
+datetime_type&
 value_type::datetime ()
 {
     if (mtag != VALUE_DATETIME)
         throw std::out_of_range ("datetime(): not datetime");
-    return mstring;
+    unshare ();
+    return mdatetime->mdata;
 }
 
-std::wstring const&
+string_type const&
 value_type::string () const
 {
     if (mtag != VALUE_STRING)
         throw std::out_of_range ("string()const: not string");
-    return mstring;
+    return mstring->mdata;
 }
 
-std::wstring&
+string_type&
 value_type::string ()
 {
     if (mtag != VALUE_STRING)
         throw std::out_of_range ("string(): not string");
-    return mstring;
+    unshare ();
+    return mstring->mdata;
 }
 
 array_value_type const&
@@ -445,7 +1331,9 @@ value_type::array () const
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("array()const: not array");
-    return marray;
+    if (mpack != PACK_NONE)
+        throw std::out_of_range ("array()const: packed array");
+    return marray->mdata;
 }
 
 array_value_type&
@@ -453,7 +1341,9 @@ value_type::array ()
 {
     if (mtag != VALUE_ARRAY)
         throw std::out_of_range ("array(): not array");
-    return marray;
+    unpack ();
+    unshare ();
+    return marray->mdata;
 }
 
 table_value_type const&
@@ -461,7 +1351,7 @@ value_type::table () const
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("table()const: not table");
-    return mtable;
+    return mtable->mdata;
 }
 
 table_value_type&
@@ -469,7 +1359,276 @@ value_type::table ()
 {
     if (mtag != VALUE_TABLE)
         throw std::out_of_range ("table(): not table");
-    return mtable;
+    unshare ();
+    return mtable->mdata;
+}
+
+bool
+value_type::exists (char const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::exists(key,n)const: not table");
+    return find_entry (mtable->mdata, key, n) != nullptr;
+}
+
+value_type const&
+value_type::get (char const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::get(key,n)const: not table");
+    value_type const* const p = find_entry (mtable->mdata, key, n);
+    if (p == nullptr)
+        throw std::out_of_range ("value_type::get(key,n)const: not found");
+    return *p;
+}
+
+value_type&
+value_type::get (char const* key, std::size_t const n)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::get(key,n): not table");
+    unshare ();
+    value_type* const p = find_entry (mtable->mdata, key, n);
+    if (p == nullptr)
+        throw std::out_of_range ("value_type::get(key,n): not found");
+    return *p;
+}
+
+value_type const*
+value_type::find (char const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    return find_entry (mtable->mdata, key, n);
+}
+
+value_type*
+value_type::find (char const* key, std::size_t const n)
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    unshare ();
+    return find_entry (mtable->mdata, key, n);
+}
+
+bool
+value_type::exists (wchar_t const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::exists(key,n)const: not table");
+    return find_entry (mtable->mdata, key, n) != nullptr;
+}
+
+value_type const&
+value_type::get (wchar_t const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::get(key,n)const: not table");
+    value_type const* const p = find_entry (mtable->mdata, key, n);
+    if (p == nullptr)
+        throw std::out_of_range ("value_type::get(key,n)const: not found");
+    return *p;
+}
+
+value_type&
+value_type::get (wchar_t const* key, std::size_t const n)
+{
+    if (mtag != VALUE_TABLE)
+        throw std::out_of_range ("value_type::get(key,n): not table");
+    unshare ();
+    value_type* const p = find_entry (mtable->mdata, key, n);
+    if (p == nullptr)
+        throw std::out_of_range ("value_type::get(key,n): not found");
+    return *p;
+}
+
+value_type const*
+value_type::find (wchar_t const* key, std::size_t const n) const
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    return find_entry (mtable->mdata, key, n);
+}
+
+value_type*
+value_type::find (wchar_t const* key, std::size_t const n)
+{
+    if (mtag != VALUE_TABLE)
+        return nullptr;
+    unshare ();
+    return find_entry (mtable->mdata, key, n);
+}
+
+bool const*
+value_type::if_boolean () const
+{
+    return mtag == VALUE_BOOLEAN ? &mboolean : nullptr;
+}
+
+int64_t const*
+value_type::if_fixnum () const
+{
+    if (mtag != VALUE_FIXNUM)
+        return nullptr;
+    if (mpack != PACK_LITERAL)
+        return &mfixnum;
+    return convert_literal (mliteral->mdata, VALUE_FIXNUM)
+        ? &mliteral->mdata.mfixnum : nullptr;
+}
+
+double const*
+value_type::if_flonum () const
+{
+    if (mtag != VALUE_FLONUM)
+        return nullptr;
+    if (mpack != PACK_LITERAL)
+        return &mflonum;
+    return convert_literal (mliteral->mdata, VALUE_FLONUM)
+        ? &mliteral->mdata.mflonum : nullptr;
+}
+
+datetime_type const*
+value_type::if_datetime () const
+{
+    return mtag == VALUE_DATETIME ? &mdatetime->mdata : nullptr;
+}
+
+string_type const*
+value_type::if_string () const
+{
+    return mtag == VALUE_STRING ? &mstring->mdata : nullptr;
+}
+
+array_value_type const*
+value_type::if_array () const
+{
+    return mtag == VALUE_ARRAY && mpack == PACK_NONE ? &marray->mdata : nullptr;
+}
+
+table_value_type const*
+value_type::if_table () const
+{
+    return mtag == VALUE_TABLE ? &mtable->mdata : nullptr;
+}
+
+packing
+value_type::packed () const
+{
+    return mtag == VALUE_ARRAY ? mpack : PACK_NONE;
+}
+
+// turn a non-empty array of only booleans, only fixnums or only flonums
+// into its packed form.
+bool
+value_type::pack ()
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_NONE)
+        return mtag == VALUE_ARRAY && mpack != PACK_NONE;
+    array_value_type const& a = marray->mdata;
+    if (a.empty ())
+        return false;
+    variation const t = a[0].mtag;
+    if (t != VALUE_BOOLEAN && t != VALUE_FIXNUM && t != VALUE_FLONUM)
+        return false;
+    for (auto const& x : a)
+        if (x.mtag != t || (t != VALUE_BOOLEAN && ! in_range (x)))
+            return false;
+    if (t == VALUE_BOOLEAN) {
+        boolean_array_type v (a.size ());
+        for (std::size_t i = 0; i < a.size (); ++i)
+            v[i] = a[i].mboolean;
+        assign_booleans (std::move (v));
+    }
+    else if (t == VALUE_FIXNUM) {
+        fixnum_array_type v (a.size ());
+        for (std::size_t i = 0; i < a.size (); ++i)
+            v[i] = a[i].fixnum ();
+        assign_fixnums (std::move (v));
+    }
+    else {
+        flonum_array_type v (a.size ());
+        for (std::size_t i = 0; i < a.size (); ++i)
+            v[i] = a[i].flonum ();
+        assign_flonums (std::move (v));
+    }
+    return true;
+}
+
+value_type&
+value_type::unpack ()
+{
+    if (mtag != VALUE_ARRAY || mpack == PACK_NONE)
+        return *this;
+    array_value_type a;
+    a.reserve (size ());
+    switch (mpack) {
+    case PACK_BOOLEAN:
+        for (bool const x : mbooleans->mdata)
+            a.push_back (::wjson::boolean (x));
+        break;
+    case PACK_FIXNUM:
+        for (int64_t const x : mfixnums->mdata)
+            a.push_back (::wjson::fixnum (x));
+        break;
+    case PACK_FLONUM:
+        for (double const x : mflonums->mdata)
+            a.push_back (::wjson::flonum (x));
+        break;
+    default:
+        break;
+    }
+    return assign_array (std::move (a));
+}
+
+boolean_array_type const&
+value_type::booleans () const
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_BOOLEAN)
+        throw std::out_of_range ("booleans()const: not packed booleans");
+    return mbooleans->mdata;
+}
+
+boolean_array_type&
+value_type::booleans ()
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_BOOLEAN)
+        throw std::out_of_range ("booleans(): not packed booleans");
+    unshare ();
+    return mbooleans->mdata;
+}
+
+fixnum_array_type const&
+value_type::fixnums () const
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_FIXNUM)
+        throw std::out_of_range ("fixnums()const: not packed fixnums");
+    return mfixnums->mdata;
+}
+
+fixnum_array_type&
+value_type::fixnums ()
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_FIXNUM)
+        throw std::out_of_range ("fixnums(): not packed fixnums");
+    unshare ();
+    return mfixnums->mdata;
+}
+
+flonum_array_type const&
+value_type::flonums () const
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_FLONUM)
+        throw std::out_of_range ("flonums()const: not packed flonums");
+    return mflonums->mdata;
+}
+
+flonum_array_type&
+value_type::flonums ()
+{
+    if (mtag != VALUE_ARRAY || mpack != PACK_FLONUM)
+        throw std::out_of_range ("flonums(): not packed flonums");
+    unshare ();
+    return mflonums->mdata;
 }
 
 void
@@ -481,26 +1640,40 @@ value_type::copy_data (value_type const& x)
         mboolean = x.mboolean;
         break;
     case VALUE_FIXNUM:
-        mfixnum = x.mfixnum;
+        if (mpack == PACK_LITERAL)
+            mliteral = share_box (x.mliteral);
+        else
+            mfixnum = x.mfixnum;
         break;
     case VALUE_FLONUM:
-        mflonum = x.mflonum;
+        if (mpack == PACK_LITERAL)
+            mliteral = share_box (x.mliteral);
+        else
+            mflonum = x.mflonum;
         break;
     case VALUE_DATETIME:
+        mdatetime = share_box (x.mdatetime);
+        break;
     case VALUE_STRING:
-        new (&mstring) std::wstring (x.mstring);
+        mstring = share_box (x.mstring);
         break;
     case VALUE_ARRAY:
-        new (&marray) array_value_type (x.marray);
+        switch (mpack) {
+        case PACK_NONE:    marray = share_box (x.marray); break;
+        case PACK_BOOLEAN: mbooleans = share_box (x.mbooleans); break;
+        case PACK_FIXNUM:  mfixnums = share_box (x.mfixnums); break;
+        case PACK_FLONUM:  mflonums = share_box (x.mflonums); break;
+        default: break;
+        }
         break;
     case VALUE_TABLE:
-        new (&mtable) table_value_type (x.mtable);
+        mtable = share_box (x.mtable);
         break;
     }
 }
 
 void
-value_type::move_data (value_type&& x)
+value_type::move_data (value_type&& x) noexcept
 {
     switch (mtag) {
     case VALUE_NULL:
@@ -508,44 +1681,148 @@ value_type::move_data (value_type&& x)
         mboolean = x.mboolean;
         break;
     case VALUE_FIXNUM:
-        mfixnum = x.mfixnum;
+        if (mpack == PACK_LITERAL)
+            mliteral = x.mliteral;
+        else
+            mfixnum = x.mfixnum;
         break;
     case VALUE_FLONUM:
-        mflonum = x.mflonum;
+        if (mpack == PACK_LITERAL)
+            mliteral = x.mliteral;
+        else
+            mflonum = x.mflonum;
+        break;
+    case VALUE_DATETIME:
+        mdatetime = x.mdatetime;
+        break;
+    case VALUE_STRING:
+        mstring = x.mstring;
+        break;
+    case VALUE_ARRAY:
+        switch (mpack) {
+        case PACK_NONE:    marray = x.marray; break;
+        case PACK_BOOLEAN: mbooleans = x.mbooleans; break;
+        case PACK_FIXNUM:  mfixnums = x.mfixnums; break;
+        case PACK_FLONUM:  mflonums = x.mflonums; break;
+        default: break;
+        }
+        break;
+    case VALUE_TABLE:
+        mtable = x.mtable;
         break;
+    }
+    x.mtag = VALUE_NULL;
+    x.mpack = PACK_NONE;
+    x.mboolean = false;
+}
+
+void
+value_type::unshare ()
+{
+    touch_epoch ();
+    switch (mtag) {
     case VALUE_DATETIME:
+        mdatetime = own_box (mdatetime);
+        break;
     case VALUE_STRING:
-        new (&mstring) std::wstring (std::move (x.mstring));
+        mstring = own_box (mstring);
         break;
     case VALUE_ARRAY:
-        new (&marray) array_value_type (std::move (x.marray));
+        switch (mpack) {
+        case PACK_NONE:    marray = own_box (marray); break;
+        case PACK_BOOLEAN: mbooleans = own_box (mbooleans); break;
+        case PACK_FIXNUM:  mfixnums = own_box (mfixnums); break;
+        case PACK_FLONUM:  mflonums = own_box (mflonums); break;
+        default: break;
+        }
         break;
     case VALUE_TABLE:
-        new (&mtable) table_value_type (std::move (x.mtable));
+        mtable = own_box (mtable);
+        break;
+    default:
         break;
     }
 }
 
 void
-value_type::destroy ()
+value_type::destroy () noexcept
 {
     switch (mtag) {
     case VALUE_NULL:
     case VALUE_BOOLEAN:
+        break;
     case VALUE_FIXNUM:
     case VALUE_FLONUM:
+        if (mpack == PACK_LITERAL)
+            drop_box (mliteral);
         break;
     case VALUE_DATETIME:
+        drop_box (mdatetime);
+        break;
     case VALUE_STRING:
-        mstring.~basic_string ();
+        drop_box (mstring);
         break;
     case VALUE_ARRAY:
-        marray.~vector ();
+        switch (mpack) {
+        case PACK_NONE:
+            if (sole_box (marray) && std::any_of (marray->mdata.cbegin (),
+                    marray->mdata.cend (), nested))
+                destroy_nested ();
+            else
+                drop_box (marray);
+            break;
+        case PACK_BOOLEAN: drop_box (mbooleans); break;
+        case PACK_FIXNUM:  drop_box (mfixnums); break;
+        case PACK_FLONUM:  drop_box (mflonums); break;
+        default: break;
+        }
         break;
     case VALUE_TABLE:
-        mtable.~map ();
+        if (sole_box (mtable) && std::any_of (mtable->mdata.cbegin (),
+                mtable->mdata.cend (),
+                [](table_value_type::value_type const& x) { return nested (x.second); }))
+            destroy_nested ();
+        else
+            drop_box (mtable);
         break;
     }
+    mpack = PACK_NONE;
+}
+
+// destroys a tree without recursion. the nested containers of a dying
+// container move to a stack before it goes, so that the destructors of
+// vectors and maps meet flat elements only. when the stack cannot grow,
+// the rest of the tree falls back to the recursive destructors.
+void
+value_type::destroy_nested () noexcept
+{
+    value_type top (std::move (*this));
+    try {
+        std::vector<value_type> stack;
+        top.move_nested (stack);
+        while (! stack.empty ()) {
+            value_type x (std::move (stack.back ()));
+            stack.pop_back ();
+            x.move_nested (stack);
+        }
+    }
+    catch (...) {
+    }
+}
+
+void
+value_type::move_nested (std::vector<value_type>& stack)
+{
+    if (mtag == VALUE_ARRAY && mpack == PACK_NONE && sole_box (marray)) {
+        for (auto& x : marray->mdata)
+            if (nested (x))
+                stack.push_back (std::move (x));
+    }
+    else if (mtag == VALUE_TABLE && sole_box (mtable)) {
+        for (auto& x : mtable->mdata)
+            if (nested (x.second))
+                stack.push_back (std::move (x.second));
+    }
 }
 
 value_type
@@ -580,7 +1857,15 @@ flonum (double const x)
 }
 
 value_type
-datetime (std::wstring const& x)
+number_literal (std::string const& x)
+{
+    value_type e;
+    e.assign_number_literal (x);
+    return e;
+}
+
+value_type
+datetime (datetime_type const& x)
 {
     value_type e;
     e.assign_datetime (x);
@@ -588,15 +1873,15 @@ datetime (std::wstring const& x)
 }
 
 value_type
-datetime (std::wstring&& x)
+datetime (string_type const& x)
 {
     value_type e;
-    e.assign_datetime (std::move (x));
+    e.assign_datetime (x);
     return e;
 }
 
 value_type
-string (std::wstring const& x)
+string (string_type const& x)
 {
     value_type e;
     e.assign_string (x);
@@ -604,7 +1889,7 @@ string (std::wstring const& x)
 }
 
 value_type
-string (std::wstring&& x)
+string (string_type&& x)
 {
     value_type e;
     e.assign_string (std::move (x));
@@ -615,7 +1900,7 @@ value_type
 string ()
 {
     value_type e;
-    e.assign_string (L"");
+    e.assign_string (string_type ());
     return e;
 }
 
@@ -635,4 +1920,90 @@ table ()
     return e;
 }
 
+value_type
+booleans (boolean_array_type const& x)
+{
+    value_type e;
+    e.assign_booleans (x);
+    return e;
+}
+
+value_type
+booleans (boolean_array_type&& x)
+{
+    value_type e;
+    e.assign_booleans (std::move (x));
+    return e;
+}
+
+value_type
+fixnums (fixnum_array_type const& x)
+{
+    value_type e;
+    e.assign_fixnums (x);
+    return e;
+}
+
+value_type
+fixnums (fixnum_array_type&& x)
+{
+    value_type e;
+    e.assign_fixnums (std::move (x));
+    return e;
+}
+
+value_type
+flonums (flonum_array_type const& x)
+{
+    value_type e;
+    e.assign_flonums (x);
+    return e;
+}
+
+value_type
+flonums (flonum_array_type&& x)
+{
+    value_type e;
+    e.assign_flonums (std::move (x));
+    return e;
+}
+
+// entries in the key order for encoders to be deterministic.
+table_entries_type
+sorted_entries (table_value_type const& x)
+{
+#if defined (WJSON_HASH_TABLE)
+    table_entries_type entries;
+    entries.reserve (x.size ());
+    for (auto& e : x)
+        entries.push_back (&e);
+    std::sort (entries.begin (), entries.end (),
+        [](table_value_type::value_type const* a, table_value_type::value_type const* b) {
+            return a->first < b->first;
+        });
+    return entries;
+#else
+    return table_entries_type (x);
+#endif
+}
+
+std::size_t
+string_hash::operator() (string_type const& s) const
+{
+    return key_type::view (s).hash ();
+}
+
+document_type::document_type (std::size_t const chunk_size)
+    : marena (chunk_size), mpool (), mroot (nullptr)
+{
+    mroot = new (marena.allocate (sizeof (value_type))) value_type;
+}
+
+document_type::~document_type ()
+{
+#if ! defined (WJSON_ARENA)
+    mroot->~value_type ();
+#endif
+}
+
 }//namespace wjson
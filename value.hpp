@@ -5,6 +5,12 @@
 #include <string>
 #include <memory>
 #include <ostream>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include "hash-table.hpp"
+#include "arena.hpp"
+#include "datetime.hpp"
 
 namespace wjson {
 
@@ -19,93 +25,387 @@ enum variation {
     VALUE_TABLE,
 };
 
+// packed forms of homogeneous arrays, and of numbers kept as literals.
+enum packing {
+    PACK_NONE,
+    PACK_BOOLEAN,
+    PACK_FIXNUM,
+    PACK_FLONUM,
+    PACK_LITERAL,
+};
+
+// flags for decoders.
+enum {
+    DECODE_PACK_ARRAY = 1,  // pack homogeneous boolean and number arrays.
+    DECODE_LAZY_NUMBER = 2, // keep numbers as literals until they are read.
+};
+
 class value_type;
 class setter_type;
+class array_elements_type;
+
+// containers use std::allocator by default.
+// build with -DWJSON_ARENA to make them arena_allocator, so that
+// values made inside an arena_scope live in its arena.
+#if defined (WJSON_ARENA)
+template<typename T> using allocator_type = arena_allocator<T>;
+#else
+template<typename T> using allocator_type = std::allocator<T>;
+#endif
+
+// strings and table keys are UTF-32 std::wstring by default.
+// build with -DWJSON_UTF8_STRING to store them as UTF-8 std::string.
+#if defined (WJSON_UTF8_STRING)
+typedef char char_type;
+#else
+typedef wchar_t char_type;
+#endif
+typedef std::basic_string<char_type, std::char_traits<char_type>,
+    allocator_type<char_type>> string_type;
+typedef std::basic_string<char, std::char_traits<char>,
+    allocator_type<char>> literal_string_type;
+
+#if defined (WJSON_ARENA)
+// strings of the arena build have their own allocator, and compare
+// with std::basic_string of the same characters.
+inline bool
+operator== (string_type const& a, std::basic_string<char_type> const& b)
+{
+    return a.compare (0, a.size (), b.data (), b.size ()) == 0;
+}
+
+inline bool
+operator== (std::basic_string<char_type> const& a, string_type const& b)
+{
+    return b == a;
+}
+
+inline bool
+operator!= (string_type const& a, std::basic_string<char_type> const& b)
+{
+    return ! (a == b);
+}
+
+inline bool
+operator!= (std::basic_string<char_type> const& a, string_type const& b)
+{
+    return ! (b == a);
+}
+#endif
+
+struct string_hash {
+    std::size_t operator() (string_type const& s) const;
+};
+
+// table keys are immutable strings in boxes shared by reference counting.
+// keys made inside an intern_scope come from its intern_pool_type, so that
+// equal keys of a document share one box and compare by the pointer.
+// key_type::view refers to characters without a box for lookups; views
+// must not outlive the characters, and their copies own boxes.
+struct key_box {
+    string_type mdata;
+    std::size_t mhash;
+    std::atomic<long> mcount;
+
+    explicit key_box (string_type const& s);
+    explicit key_box (string_type&& s);
+};
+
+class key_type {
+public:
+    key_type (string_type const& s);
+    key_type (string_type&& s);
+    key_type (char_type const* s);
+    key_type (key_type const& x);
+    key_type (key_type&& x) noexcept;
+    ~key_type ();
+    key_type& operator= (key_type const& x);
+    key_type& operator= (key_type&& x) noexcept;
+    static key_type view (char_type const* p, std::size_t const n) noexcept;
+    static key_type view (string_type const& s) noexcept;
+
+    char_type const* data () const { return mdata; }
+    std::size_t size () const { return msize; }
+    std::size_t hash () const;
+    bool interned_with (key_type const& x) const;
+    string_type const& str () const;
+    operator string_type const& () const { return str (); }
+
+private:
+    key_box* mbox;
+    char_type const* mdata;
+    std::size_t msize;
+
+    key_type () noexcept;
+    void release () noexcept;
+};
 
-typedef std::vector<value_type> array_value_type;
-typedef std::map<std::wstring,value_type> table_value_type;
+bool operator== (key_type const& a, key_type const& b);
+bool operator!= (key_type const& a, key_type const& b);
+bool operator< (key_type const& a, key_type const& b);
 
+struct key_hash {
+    std::size_t operator() (key_type const& k) const { return k.hash (); }
+};
+
+class intern_pool_type {
+public:
+    intern_pool_type ();
+    key_type intern (string_type const& s);
+    key_type intern (string_type&& s);
+    std::size_t size () const;
+    void clear ();
+
+private:
+    hash_table<key_type, bool, key_hash> mkeys;
+
+    intern_pool_type (intern_pool_type const&);
+    intern_pool_type& operator= (intern_pool_type const&);
+};
+
+inline intern_pool_type*&
+current_pool ()
+{
+    static thread_local intern_pool_type* pool = nullptr;
+    return pool;
+}
+
+// value_type makes new table keys in the pool while a scope lives.
+class intern_scope {
+public:
+    explicit intern_scope (intern_pool_type& pool) : mprev (current_pool ())
+    {
+        current_pool () = &pool;
+    }
+    ~intern_scope () { current_pool () = mprev; }
+
+private:
+    intern_pool_type* mprev;
+
+    intern_scope (intern_scope const&);
+    intern_scope& operator= (intern_scope const&);
+};
+
+// tables are std::map by default.
+// build with -DWJSON_HASH_TABLE to make them open addressing hash_table.
+typedef std::vector<value_type, allocator_type<value_type>> array_value_type;
+typedef std::vector<bool, allocator_type<bool>> boolean_array_type;
+typedef std::vector<int64_t, allocator_type<int64_t>> fixnum_array_type;
+typedef std::vector<double, allocator_type<double>> flonum_array_type;
+#if defined (WJSON_HASH_TABLE)
+typedef hash_table<key_type, value_type, key_hash,
+    std::equal_to<key_type>,
+    allocator_type<std::pair<key_type,value_type>>> table_value_type;
+#else
+typedef std::map<key_type, value_type, std::less<key_type>,
+    allocator_type<std::pair<key_type const,value_type>>> table_value_type;
+#endif
+
+// the epoch of writes through the non-const accessors of values.
+// it changes on the next write after a call, so that a cache over
+// a tree holds while the epoch stays the same.
+std::size_t watch_writes ();
+
+// mkey is an empty view for an array segment.
 struct setter_segment_type {
     variation mtag;
     std::size_t midx;
-    std::wstring mkey;
+    key_type mkey;
+
+    setter_segment_type ();
+    setter_segment_type (variation const tag, std::size_t const idx,
+        key_type const& key);
 };
 
+// setter_type keeps the segments of value[k1][k2]... in a small inline
+// buffer, with keys interned in the current intern_scope. reads walk
+// the tree by the const accessors, and keep the parent of the last
+// segment until the next write to any value; writes walk the path again
+// and make the missing containers, and the key of a new entry is
+// the key of its segment. a setter is for one thread.
 class setter_type {
 public:
     setter_type (value_type& value, std::size_t idx);
-    setter_type (value_type& value, std::wstring const& k);
+    setter_type (value_type& value, string_type const& k);
     setter_type& operator[] (value_type const& k);
     setter_type& operator[] (std::size_t idx);
-    setter_type& operator[] (std::wstring const& k);
+    setter_type& operator[] (string_type const& k);
     setter_type& operator= (value_type const& x);
     setter_type& operator= (value_type&& x);
-    setter_type& operator= (std::wstring const& x);
-    setter_type& operator= (std::wstring&& x);
+    setter_type& operator= (string_type const& x);
+    setter_type& operator= (string_type&& x);
 
     variation tag () const;
     bool const& boolean () const;
     int64_t const& fixnum () const;
     double const& flonum () const;
-    std::wstring const& datetime () const;
-    std::wstring const& string () const;
+    datetime_type const& datetime () const;
+    string_type const& string () const;
     array_value_type const& array () const;
     table_value_type const& table () const;
     value_type* lookup () const;
     bool exists () const;
 
 private:
-    value_type* force ();
+    enum { INLINE_SEGMENTS = 4 };
 
     value_type& mvalue;
-    std::vector<setter_segment_type> mpath;
+    std::size_t msize;
+    setter_segment_type minline[INLINE_SEGMENTS];
+    std::vector<setter_segment_type> mspill;
+    mutable value_type const* mparent;
+    mutable std::size_t mepoch;
+
+    void push (variation const tag, std::size_t const idx, key_type const& k);
+    setter_segment_type& segment (std::size_t const i);
+    setter_segment_type const& segment (std::size_t const i) const;
+    value_type const* parent () const;
+    value_type const* target () const;
+    value_type const* packed_target (packing const pack) const;
+    value_type* force ();
+    void store (value_type&& x);
+};
+
+// a number kept as its literal converts on the first read into mfixnum
+// or mflonum. mstate is LITERAL_TEXT before it, LITERAL_BUSY while
+// a reader converts it, and then LITERAL_NUMBER, or LITERAL_RANGE
+// when the number does not fit.
+struct number_literal_type {
+    enum { LITERAL_TEXT, LITERAL_BUSY, LITERAL_NUMBER, LITERAL_RANGE };
+
+    literal_string_type mtext;
+    union {
+        int64_t mfixnum;
+        double mflonum;
+    };
+    std::atomic<int> mstate;
+
+    explicit number_literal_type (std::string const& s);
+    number_literal_type (number_literal_type const& x);
+};
+
+// strings and containers of value_type live in boxes.
+// build with -DWJSON_SHARED_VALUE to share boxes between copies
+// by reference counting, and to copy them on the first write.
+// mhash caches value_type::hash computed in the epoch mepoch,
+// and mepoch 0 means not computed yet.
+template<typename T>
+struct value_box {
+    T mdata;
+    std::atomic<std::size_t> mhash;
+    std::atomic<std::size_t> mepoch;
+#if defined (WJSON_SHARED_VALUE)
+    std::atomic<long> mcount;
+#endif
+
+    template<typename... A>
+    explicit value_box (A&&... args)
+        : mdata (std::forward<A> (args)...), mhash (0), mepoch (0)
+#if defined (WJSON_SHARED_VALUE)
+        , mcount (1)
+#endif
+    {
+    }
 };
 
 class value_type {
 public:
     value_type ();
     value_type (value_type const& x);
-    value_type (value_type&& x);
+    value_type (value_type&& x) noexcept;
     ~value_type ();
     value_type& operator= (value_type const& x);
-    value_type& operator= (value_type&& x);
+    value_type& operator= (value_type&& x) noexcept;
 
     value_type& assign_null ();
     value_type& assign_boolean (bool const x);
     value_type& assign_fixnum (int64_t const x);
     value_type& assign_flonum (double const x);
-    value_type& assign_datetime (std::wstring const& x);
-    value_type& assign_datetime (std::wstring&& x);
-    value_type& assign_string (std::wstring const& x);
-    value_type& assign_string (std::wstring&& x);
+    value_type& assign_number_literal (std::string const& x);
+    value_type& assign_datetime (datetime_type const& x);
+    value_type& assign_datetime (string_type const& x);
+    value_type& assign_string (string_type const& x);
+    value_type& assign_string (string_type&& x);
     value_type& assign_array (array_value_type const& x);
     value_type& assign_array (array_value_type&& x);
     value_type& assign_table (table_value_type const& x);
     value_type& assign_table (table_value_type&& x);
+    value_type& assign_booleans (boolean_array_type const& x);
+    value_type& assign_booleans (boolean_array_type&& x);
+    value_type& assign_fixnums (fixnum_array_type const& x);
+    value_type& assign_fixnums (fixnum_array_type&& x);
+    value_type& assign_flonums (flonum_array_type const& x);
+    value_type& assign_flonums (flonum_array_type&& x);
 
     setter_type operator[] (value_type const& k);
     setter_type operator[] (std::size_t idx);
-    setter_type operator[] (std::wstring const& k);
+    setter_type operator[] (string_type const& k);
 
     bool exists (value_type const& k) const;
     bool exists (std::size_t const idx) const;
-    bool exists (std::wstring const& key) const;
+    bool exists (string_type const& key) const;
     value_type const& get (value_type const& k) const;
     value_type& get (value_type const& k);
     value_type const& get (std::size_t const idx) const;
     value_type& get (std::size_t const idx);
-    value_type const& get (std::wstring const& key) const;
-    value_type& get (std::wstring const& key);
+    value_type const& get (string_type const& key) const;
+    value_type& get (string_type const& key);
+    // find returns nullptr instead of throwing out_of_range
+    // when this is not a container or the element does not exist.
+    // the const one returns nullptr also on a packed array.
+    value_type const* find (value_type const& k) const;
+    value_type* find (value_type const& k);
+    value_type const* find (std::size_t const idx) const;
+    value_type* find (std::size_t const idx);
+    value_type const* find (string_type const& key) const;
+    value_type* find (string_type const& key);
+    // element copies an element, reading packed arrays in place.
+    // elements walks the elements of an array of any packing.
+    value_type element (std::size_t const idx) const;
+    array_elements_type elements () const;
+
+    // lookups with narrow UTF-8 or wide keys of n characters compare
+    // them with the stored keys without making string_type.
+    bool exists (char const* key, std::size_t const n) const;
+    bool exists (wchar_t const* key, std::size_t const n) const;
+    value_type const& get (char const* key, std::size_t const n) const;
+    value_type& get (char const* key, std::size_t const n);
+    value_type const& get (wchar_t const* key, std::size_t const n) const;
+    value_type& get (wchar_t const* key, std::size_t const n);
+    value_type const* find (char const* key, std::size_t const n) const;
+    value_type* find (char const* key, std::size_t const n);
+    value_type const* find (wchar_t const* key, std::size_t const n) const;
+    value_type* find (wchar_t const* key, std::size_t const n);
     value_type& set (value_type const& k, value_type const& x);
     value_type& set (value_type const& k, value_type&& x);
     value_type& set (std::size_t const idx, value_type const& x);
     value_type& set (std::size_t const idx, value_type&& x);
     value_type& push_back (value_type const& x);
     value_type& push_back (value_type&& x);
-    value_type& set (std::wstring const& key, value_type const& x);
-    value_type& set (std::wstring const& key, value_type&& x);
+    value_type& set (string_type const& key, value_type const& x);
+    value_type& set (string_type const& key, value_type&& x);
+    value_type& set (string_type&& key, value_type&& x);
+
+    // emplace_back and emplace return the element made in place,
+    // and emplace keeps the element when key exists.
+    value_type& emplace_back ();
+    value_type& emplace_back (value_type&& x);
+    value_type& emplace (string_type const& key);
+    value_type& emplace (string_type&& key);
+    value_type& emplace (string_type&& key, value_type&& x);
+    void reserve (std::size_t const n);
+
+    void swap (value_type& x) noexcept;
+
+    // equal compares trees deeply, packed arrays as their elements,
+    // and tells unequal boxes apart by their cached hashes at once.
+    // hash is a structural hash cached in the boxes of strings and
+    // containers. a call of the non-const accessors drops the cached
+    // hashes of all trees; a write through a reference they returned
+    // before a hash () call is not seen after it.
+    bool equal (value_type const& x) const;
+    std::size_t hash () const;
 
-    void swap (value_type& x);
     variation tag () const;
     std::size_t size () const;
     bool const& boolean () const;
@@ -114,45 +414,211 @@ public:
     int64_t& fixnum ();
     double const& flonum () const;
     double& flonum ();
-    std::wstring const& datetime () const;
-    std::wstring& datetime ();
-    std::wstring const& string () const;
-    std::wstring& string ();
+    datetime_type const& datetime () const;
+    datetime_type& datetime ();
+    string_type const& string () const;
+    string_type& string ();
     array_value_type const& array () const;
     array_value_type& array ();
     table_value_type const& table () const;
     table_value_type& table ();
 
+    // a number literal has VALUE_FIXNUM tag, or VALUE_FLONUM when it has
+    // a fraction or an exponent. the const accessors convert it once and
+    // throw out_of_range when it does not fit, and the non-const ones
+    // turn it into a plain number. literal returns its text, or nullptr
+    // on other values.
+    literal_string_type const* literal () const;
+
+    // if_ accessors return nullptr instead of throwing on other tags,
+    // and on number literals that do not fit.
+    bool const* if_boolean () const;
+    int64_t const* if_fixnum () const;
+    double const* if_flonum () const;
+    datetime_type const* if_datetime () const;
+    string_type const* if_string () const;
+    array_value_type const* if_array () const;
+    table_value_type const* if_table () const;
+
+    // a packed array has VALUE_ARRAY tag and its elements in a vector
+    // of bool, int64_t or double. array () and the other accessors for
+    // elements unpack it into values, except for the const ones, which
+    // throw out_of_range. element () and elements () read it without
+    // unpacking.
+    packing packed () const;
+    bool pack ();
+    value_type& unpack ();
+    boolean_array_type const& booleans () const;
+    boolean_array_type& booleans ();
+    fixnum_array_type const& fixnums () const;
+    fixnum_array_type& fixnums ();
+    flonum_array_type const& flonums () const;
+    flonum_array_type& flonums ();
+
 private:
+    // strings and containers are out of line to keep 16 bytes.
     variation mtag;
+    packing mpack;
     union {
         bool mboolean;
         int64_t mfixnum;
         double mflonum;
-        std::wstring mstring;
-        array_value_type marray;
-        table_value_type mtable;
+        value_box<datetime_type>* mdatetime;
+        value_box<string_type>* mstring;
+        value_box<array_value_type>* marray;
+        value_box<table_value_type>* mtable;
+        value_box<boolean_array_type>* mbooleans;
+        value_box<fixnum_array_type>* mfixnums;
+        value_box<flonum_array_type>* mflonums;
+        value_box<number_literal_type>* mliteral;
     };
     void copy_data (value_type const& x);
-    void move_data (value_type&& x);
-    void destroy ();
+    void move_data (value_type&& x) noexcept;
+    void unshare ();
+    void destroy () noexcept;
+    void destroy_nested () noexcept;
+    void move_nested (std::vector<value_type>& stack);
+
+    friend class array_elements_type;
 };
 
+static_assert (sizeof (value_type) <= 16, "value_type: not compact");
+// vectors move elements on growth only when moves cannot throw.
+static_assert (std::is_nothrow_move_constructible<value_type>::value
+    && std::is_nothrow_move_assignable<value_type>::value,
+    "value_type: moves may throw");
+
 value_type null ();
 value_type boolean (bool const x);
 value_type fixnum (int64_t const x);
 value_type flonum (double const x);
-value_type datetime (std::wstring const& x);
-value_type datetime (std::wstring&& x);
-value_type string (std::wstring const& x);
-value_type string (std::wstring&& x);
+value_type number_literal (std::string const& x);
+value_type datetime (datetime_type const& x);
+value_type datetime (string_type const& x);
+value_type string (string_type const& x);
+value_type string (string_type&& x);
 value_type string ();
 value_type array ();
 value_type table ();
+value_type booleans (boolean_array_type const& x);
+value_type booleans (boolean_array_type&& x);
+value_type fixnums (fixnum_array_type const& x);
+value_type fixnums (fixnum_array_type&& x);
+value_type flonums (flonum_array_type const& x);
+value_type flonums (flonum_array_type&& x);
+
+inline bool
+operator== (value_type const& a, value_type const& b)
+{
+    return a.equal (b);
+}
+
+inline bool
+operator!= (value_type const& a, value_type const& b)
+{
+    return ! a.equal (b);
+}
 
+// value_hash keys hash_table with values, for example to find
+// identical subtrees and share them between documents.
+struct value_hash {
+    std::size_t operator() (value_type const& x) const { return x.hash (); }
+};
+
+// the elements of an array of any packing, for reads. the iterator
+// keeps an element of a packed array as a value, so that a reference
+// to it holds until the iterator moves.
+class array_elements_type {
+public:
+    class const_iterator {
+    public:
+        const_iterator (value_type const& array, std::size_t const idx)
+            : marray (&array), midx (idx), melement () {}
+        value_type const& operator* () const { return at (*marray, midx, melement); }
+        value_type const* operator-> () const { return &**this; }
+        const_iterator& operator++ () { ++midx; return *this; }
+        bool operator== (const_iterator const& x) const { return midx == x.midx; }
+        bool operator!= (const_iterator const& x) const { return midx != x.midx; }
+    private:
+        value_type const* marray;
+        std::size_t midx;
+        mutable value_type melement;
+    };
+
+    explicit array_elements_type (value_type const& x) : marray (&x) {}
+    std::size_t size () const { return marray->size (); }
+    const_iterator begin () const { return const_iterator (*marray, 0); }
+    const_iterator end () const { return const_iterator (*marray, size ()); }
+    const_iterator cbegin () const { return begin (); }
+    const_iterator cend () const { return end (); }
+private:
+    value_type const* marray;
+
+    static value_type const& at (value_type const& array, std::size_t const idx,
+        value_type& scalar);
+};
+
+// entries of a table in the key order, as pointers to its entries.
+#if defined (WJSON_HASH_TABLE)
+typedef std::vector<table_value_type::value_type const*> table_entries_type;
+#else
+// the map is in the key order already, so that its entries are
+// visited in place.
+class table_entries_type {
+public:
+    class const_iterator {
+    public:
+        explicit const_iterator (table_value_type::const_iterator const it)
+            : miter (it) {}
+        table_value_type::value_type const* operator* () const { return &*miter; }
+        const_iterator& operator++ () { ++miter; return *this; }
+        bool operator== (const_iterator const& x) const { return miter == x.miter; }
+        bool operator!= (const_iterator const& x) const { return miter != x.miter; }
+    private:
+        table_value_type::const_iterator miter;
+    };
+
+    explicit table_entries_type (table_value_type const& x) : mtable (&x) {}
+    const_iterator begin () const { return const_iterator (mtable->cbegin ()); }
+    const_iterator end () const { return const_iterator (mtable->cend ()); }
+    const_iterator cbegin () const { return begin (); }
+    const_iterator cend () const { return end (); }
+private:
+    table_value_type const* mtable;
+};
+#endif
+
+table_entries_type sorted_entries (table_value_type const& x);
 bool exists (setter_type const& setter);
 
+/* document_type owns a root value, the arena for its contents
+ * and the pool of its table keys.
+ * decode into it with the document overloads of decoders, or build
+ * values inside arena_scope scope (doc.arena ()) and
+ * intern_scope keys (doc.pool ()).
+ * with -DWJSON_ARENA the destructor drops the arena without walking
+ * the tree, otherwise it destroys the root value as usual.
+ */
+class document_type {
+public:
+    explicit document_type (std::size_t const chunk_size = 1024 * 1024);
+    ~document_type ();
+    value_type& root () { return *mroot; }
+    value_type const& root () const { return *mroot; }
+    arena_type& arena () { return marena; }
+    intern_pool_type& pool () { return mpool; }
+
+private:
+    arena_type marena;
+    intern_pool_type mpool;
+    value_type* mroot;
+
+    document_type (document_type const&);
+    document_type& operator= (document_type const&);
+};
+
 }//namespace wjson
 
-std::wostream& operator<< (std::wostream& out, wjson::setter_type const& setter);
+std::basic_ostream<wjson::char_type>& operator<< (
+    std::basic_ostream<wjson::char_type>& out, wjson::setter_type const& setter);
 
@@ -1650,7 +1650,7 @@ R"__(null)__"
 int main ()
 {
     int tests = sizeof (spec) / sizeof (spec[0]);
-    test::simple ts (tests);
+    test::simple ts (tests * 2);
     for (int i = 0; i < tests; i++) {
         std::string input (spec[i].input);
         wjson::value_type value;
@@ -1661,6 +1661,14 @@ int main ()
             ts.diag (got);
         }
     }
+    for (int i = 0; i < tests; i++) {
+        std::string input (spec[i].input);
+        wjson::value_type value;
+        bool res = wjson::decode_yaml (input, value, 0, wjson::DECODE_PACK_ARRAY);
+        std::string got = wjson::encode_json (value);
+        ts.ok (res && got == spec[i].expected,
+            std::string ("packed ") + spec[i].name);
+    }
     return ts.done_testing ();
 }
 
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include "value.hpp"
 #include "encode-utf8.hpp"
+#include "decode-number.hpp"
 
 namespace wjson {
 
@@ -39,6 +40,7 @@ private:
 };
 
 static int c7toi (int const c);
+static void pack_arrays (value_type& value);
 static int l_endstream (derivs_type s);
 static bool l_document (derivs_type& s, value_type& value);
 static bool c_forbidden (derivs_type s);
@@ -90,8 +92,11 @@ static int c7toi (int c)
 }
 
 std::string::size_type
-decode_yaml (std::string const& input, value_type& value, std::string::size_type pos)
+decode_yaml (std::string const& input, value_type& value,
+    std::string::size_type pos, int const flags)
 {
+    intern_pool_type pool;
+    intern_scope keys (current_pool () ? *current_pool () : pool);
     derivs_type s (input.cbegin (), input.cend ());
     s.advance (pos);
     int endok = l_endstream (s);
@@ -102,9 +107,33 @@ decode_yaml (std::string const& input, value_type& value, std::string::size_type
         return input.size ();
     }
     bool ok = l_document (s, value);
+    if (ok && (flags & DECODE_PACK_ARRAY))
+        pack_arrays (value);
     return ok ? s.cend () - input.cbegin () : std::string::npos;
 }
 
+std::string::size_type
+decode_yaml (std::string const& input, document_type& doc,
+    std::string::size_type pos, int const flags)
+{
+    arena_scope scope (doc.arena ());
+    intern_scope keys (doc.pool ());
+    return decode_yaml (input, doc.root (), pos, flags);
+}
+
+static void
+pack_arrays (value_type& value)
+{
+    if (value.tag () == VALUE_TABLE) {
+        for (auto& x : value.table ())
+            pack_arrays (x.second);
+    }
+    else if (value.tag () == VALUE_ARRAY && ! value.pack ()) {
+        for (auto& x : value.array ())
+            pack_arrays (x);
+    }
+}
+
 static int
 l_endstream (derivs_type s)
 {
@@ -279,7 +308,7 @@ ns_l_compact_mapping (derivs_type& s0, int const n, value_type& value)
 static bool
 ns_l_block_map_entry (derivs_type& s0, int const n, value_type& value)
 {
-    value_type key = ::wjson::string (L"");
+    value_type key = ::wjson::string ();
     value_type item;
     derivs_type s = s0;
     ns_flow_scalar (s, 0, BLOCK_KEY, key);
@@ -344,7 +373,7 @@ c_flow_mapping (derivs_type& s0, int const n, int const ctx0, value_type& value)
     s_separate (s, n, ctx0);
     int const ctx = (BLOCK_KEY == ctx0 || FLOW_KEY == ctx0) ? FLOW_KEY : FLOW_IN;
     for (;;) {
-        value_type key = ::wjson::string (L"");
+        value_type key = ::wjson::string ();
         value_type item;
         int got = 0;
         derivs_type la = s;
@@ -429,7 +458,7 @@ c_l_scalar (derivs_type& s0, int const n0, value_type& value)
         octets.push_back ('\n');
     if (! l_trail_comments (s, n))
         return s0.fail ();
-    std::wstring lit;
+    string_type lit;
     if (! decode_utf8 (octets, lit))
         return s0.fail ();
     value = ::wjson::string (lit);
@@ -490,7 +519,7 @@ ns_plain (derivs_type& s0, int const n, int const ctx, value_type& value)
         octets.push_back (s.get ());
     }
     if (BLOCK_KEY == ctx || FLOW_KEY == ctx) {
-        std::wstring lit;
+        string_type lit;
         if (! decode_utf8 (octets, lit))
             return s0.fail ();
         value = ::wjson::string (lit);
@@ -504,7 +533,7 @@ ns_plain (derivs_type& s0, int const n, int const ctx, value_type& value)
         else if (octets == "false" || octets == "FALSE" || octets == "False")
             value = ::wjson::boolean (false);
         else if (! scan_number (octets, value)) {
-            std::wstring lit;
+            string_type lit;
             if (! decode_utf8 (octets, lit))
                 return s0.fail ();
             value = ::wjson::string (lit);
@@ -560,7 +589,7 @@ scan_number (std::string const& string, value_type& value)
     static const uint32_t MATCH = 14U;
     int kind = TOKEN_INVALID;
     int base = 10;
-    std::wstring literal;
+    std::string literal;
     std::string::const_iterator s = string.cbegin ();
     std::string::const_iterator const e = string.cend ();
     for (int next_state = 1; s <= e; ++s) {
@@ -594,14 +623,13 @@ scan_number (std::string const& string, value_type& value)
     }
     if (s < e)
         return TOKEN_INVALID;
-    try {
-        std::size_t pos = 0;
-        if (TOKEN_FIXNUM == kind)
-            value = ::wjson::fixnum (std::stoll (literal, &pos, base));
-        else if (TOKEN_FLONUM == kind)
-            value = ::wjson::flonum (std::stod (literal));
-    }
-    catch (std::out_of_range) {
+    int64_t fixnum;
+    double flonum;
+    if (TOKEN_FIXNUM == kind && decode_fixnum (literal, fixnum, base))
+        value = ::wjson::fixnum (fixnum);
+    else if (TOKEN_FLONUM == kind && decode_flonum (literal, flonum))
+        value = ::wjson::flonum (flonum);
+    else if (TOKEN_FIXNUM == kind || TOKEN_FLONUM == kind) {
         value = ::wjson::null ();
         return TOKEN_INVALID;
     }
@@ -652,7 +680,7 @@ c_quoted (derivs_type& s0, int const n, int const ctx, value_type& value)
         if (! c_escaped (s, n, ctx, octets))
             return s0.fail ();
     }
-    std::wstring lit;
+    string_type lit;
     if (! decode_utf8 (octets, lit))
         return s0.fail ();
     value = ::wjson::string (lit);
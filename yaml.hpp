@@ -6,7 +6,10 @@
 
 namespace wjson {
 
-std::string::size_type decode_yaml (std::string const& input, value_type& value, std::string::size_type pos = 0);
+std::string::size_type decode_yaml (std::string const& input, value_type& value,
+    std::string::size_type pos = 0, int const flags = 0);
+std::string::size_type decode_yaml (std::string const& input, document_type& doc,
+    std::string::size_type pos = 0, int const flags = 0);
 
 }//namespace wjson
 